@@ -1,45 +1,75 @@
 #include "AI.h"
 
-AI::AI(const std::int8_t& pieceToUse)
-	: pieceBeingUsed(pieceToUse)
+template <class BoardT>
+AI<BoardT>::AI(const std::int8_t& pieceToUse)
+	: movePriorities(std::make_shared<DataType>()), pieceBeingUsed(pieceToUse)
 {}
 
-AI::AI(const std::int8_t & pieceToUse, const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>>& data)
-	: pieceBeingUsed(pieceToUse)
+template <class BoardT>
+AI<BoardT>::AI(const std::int8_t & pieceToUse, const DataType& data)
+	: movePriorities(std::make_shared<DataType>()), pieceBeingUsed(pieceToUse)
 {
 	rememberData(data);
 }
 
-AI::~AI()
+template <class BoardT>
+AI<BoardT>::AI(const std::int8_t& pieceToUse, const std::uint64_t& seed)
+	: movePriorities(std::make_shared<DataType>()), pieceBeingUsed(pieceToUse), random(seed)
+{}
+
+template <class BoardT>
+AI<BoardT>::AI(const std::int8_t& pieceToUse, const std::uint64_t& seed, const std::shared_ptr<DataType>& sharedData)
+	: movePriorities(sharedData), pieceBeingUsed(pieceToUse), random(seed)
+{}
+
+template <class BoardT>
+AI<BoardT>::~AI()
+{
+	currentGame.clear();
+}
+
+template <class BoardT>
+void AI<BoardT>::rememberData(const DataType& data)
 {
-	movePriorities.clear();
-	boardsFoundInGame.clear();
-	indicesOfMoves.clear();
+	*movePriorities = data;
 }
 
-void AI::rememberData(const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>>& data)
+template <class BoardT>
+const typename AI<BoardT>::DataType AI<BoardT>::getData() const
 {
-	movePriorities = data;
+	return *movePriorities;
 }
 
-const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>> AI::getData() const
+template <class BoardT>
+void AI<BoardT>::setMemoryLimit(const std::size_t& bytes)
 {
-	return movePriorities;
+	movePriorities->setMemoryLimit(bytes);
+	trimToMemoryLimit();
 }
 
-void AI::initPriorities(Board& board)
+template <class BoardT>
+void AI<BoardT>::trimToMemoryLimit()
 {
-	//Create a map to hold all of the generated priorities
-	std::map<std::uint8_t, std::uint8_t> generatedPriorities;
-
-	//Generate the priorities
-	for (std::uint8_t col = 0; col < Board::NUM_COLS; col++) {
-		//If the column is full, this move is impossible
-		if (!board.colIsFull(col)) {
-			generatedPriorities.emplace(col, PRIORITY_INIT_VALUE);
-		}
+	if (movePriorities->isLimited()) {
+		movePriorities->trimToLimit(isStillUsed);
 	}
+}
+
+template <class BoardT>
+typename AI<BoardT>::PriorityList AI<BoardT>::initPriorities(const KeyType& key)
+{
+	PriorityList generatedPriorities;
+	generatedPriorities.legalMoves = BoardT::legalMovesOfKey(key);
+	generatedPriorities.visits = 0;
+
+	//Generate the priorities, where a full column is an impossible move
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		generatedPriorities.priorities[col] = (generatedPriorities.legalMoves >> col) & 1 ? PRIORITY_INIT_VALUE : 0;
+	}
+
+	return generatedPriorities;
+}
 
-	//Map the priorities to the current board
-	movePriorities.emplace(board.getBoard(), generatedPriorities);
-}
\ No newline at end of file
+template class AI<Board4x5>;
+template class AI<Board5x6>;
+template class AI<Board6x7>;
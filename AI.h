@@ -1,17 +1,88 @@
-#include <map>
 #include <array>
-#include <vector>
+#include <cassert>
+#include <memory>
 #include <typeinfo>
 #include "Board.h"
+#include "ShardedPositionTable.h"
+#include "FrozenModel.h"
 #include "Random.h"
+#include "Telemetry.h"
 
 #pragma once
+/*
+An AI that learns which moves to make by playing games
+@param BoardT The type of board the AI plays on
+*/
+template <class BoardT>
 class AI
 {
 public:
-	static const std::uint8_t PRIORITY_INIT_VALUE = 10;
-	static const std::uint8_t SPEED_PRIORITY_MODIFIER = 20;
-	static const std::uint8_t MAX_PRIORITY_VALUE = 250;
+	static constexpr std::uint8_t PRIORITY_INIT_VALUE = 10;
+	static constexpr std::uint8_t SPEED_PRIORITY_MODIFIER = 20;
+	static constexpr std::uint8_t MAX_PRIORITY_VALUE = 250;
+
+	//The bits left over in the byte holding the legal moves, which count the recent uses of a board
+	static constexpr std::uint8_t VISIT_BITS = 8 - BoardT::NUM_COLS;
+
+	//The number of sweeps of the eviction clock a board survives without being used again once it has been used this many times
+	static constexpr std::uint8_t MAX_VISITS = VISIT_BITS < 2 ? (1 << VISIT_BITS) - 1 : 3;
+
+	typedef typename BoardT::KeyType KeyType;
+
+	/*
+	The priority of every move on one board
+	*/
+	struct PriorityList
+	{
+		//The priority of each column, which is always 0 for columns that cannot be played
+		std::array<std::uint8_t, BoardT::NUM_COLS> priorities;
+
+		//Bit n is set if column n could be played on the board
+		std::uint8_t legalMoves : BoardT::NUM_COLS;
+
+		//Recent uses of the board, counting up to MAX_VISITS while the table has a memory limit and down as the eviction clock passes
+		//This shares a byte with legalMoves so it costs no memory, and since it is not saved and is not part of the priorities it is ignored when comparing them
+		std::uint8_t visits : VISIT_BITS;
+
+		inline bool operator==(const PriorityList& other) const { return priorities == other.priorities && legalMoves == other.legalMoves; }
+		inline bool operator!=(const PriorityList& other) const { return !(*this == other); }
+	};
+
+	static_assert(BoardT::NUM_COLS < 8, "legalMoves needs one bit per column and visits needs at least one more");
+
+	//The most moves a whole game can last, which no one player can exceed
+	static constexpr std::uint8_t MAX_MOVES_PER_GAME = BoardT::NUM_ROWS * BoardT::NUM_COLS;
+
+	static_assert(BoardT::NUM_ROWS * BoardT::NUM_COLS <= UINT8_MAX, "The length of a trajectory must fit within a std::uint8_t");
+
+	/*
+	Every board the AI has moved on during a game and the move it chose, stored inline so recording a game never allocates
+	*/
+	struct Trajectory
+	{
+		std::array<KeyType, MAX_MOVES_PER_GAME> boards;
+		std::array<std::uint8_t, MAX_MOVES_PER_GAME> moves;
+		std::uint8_t length = 0;
+
+		/*
+		Records a move
+		Every game must be ended with learnFromGame or endCurrentGame before the next one starts, so the buffer never fills
+		@param board The key of the board the move was made on
+		@param move The column that was chosen
+		*/
+		inline void record(const KeyType& board, const std::uint8_t& move) {
+			assert(length < MAX_MOVES_PER_GAME && "More moves were recorded than a game can last");
+
+			boards[length] = board;
+			moves[length] = move;
+			length++;
+		}
+
+		inline void clear() { length = 0; }
+	};
+
+	//Maps the keys of boards with certain combinations of pieces on the board to the priorities of their moves
+	typedef ShardedPositionTable<PriorityList> DataType;
 
 	/*
 	Initializes the piece this AI will be playing with
@@ -24,7 +95,23 @@ public:
 	@param pieceToUse The piece that the AI will be playing with (either RED_PIECE or YELLOW_PIECE)
 	@param data The data to recall
 	*/
-	AI(const std::int8_t& pieceToUse, const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>>& data);
+	AI(const std::int8_t& pieceToUse, const DataType& data);
+
+	/*
+	Initializes the piece this AI will be playing with and seeds its random choices so games can be replayed exactly
+	@param pieceToUse The piece that the AI will be playing with (either RED_PIECE or YELLOW_PIECE)
+	@param seed The seed for the AI's random number generator
+	*/
+	AI(const std::int8_t& pieceToUse, const std::uint64_t& seed);
+
+	/*
+	Initializes an AI that learns into the same data as other AI objects, such as one per training thread
+	The shared data must be marked as concurrent while more than one thread uses it
+	@param pieceToUse The piece that the AI will be playing with (either RED_PIECE or YELLOW_PIECE)
+	@param seed The seed for the AI's random number generator
+	@param sharedData The data to share, as returned by getSharedData
+	*/
+	AI(const std::int8_t& pieceToUse, const std::uint64_t& seed, const std::shared_ptr<DataType>& sharedData);
 
 	~AI();
 
@@ -34,142 +121,180 @@ public:
 	@param board The current board
 	@return std::uint8_t The column the AI placed its piece in
 	*/
-	inline const std::uint8_t makeMove(Board& board) {
-		//First, make sure the map has a key equal to this board
-		if (movePriorities.find(board.getBoard()) == movePriorities.end()) {
-			//Initialize the priority list
-			initPriorities(board);
-		}
+	inline const std::uint8_t makeMove(BoardT& board) {
+		const KeyType currentBoard = board.getKey();
+		const std::uint8_t indexOfChosenMove = chooseMove(currentBoard, board.getPieceMask(pieceBeingUsed), board.getOccupiedMask());
+
+		board.addPiece(indexOfChosenMove, pieceBeingUsed);
+		//Save this board and move in the list
+		currentGame.record(currentBoard, indexOfChosenMove);
+		return indexOfChosenMove;
+	}
+
+	/*
+	Chooses a move to make on a board without making it or remembering it, for games that are kept by the caller such as those played in batches
+	@param currentBoard The key of the current board, on which it must be this AI's turn
+	@param ownPieces The bitboard of this AI's pieces
+	@param occupied The bitboard of every piece on the board
+	@return std::uint8_t The column chosen
+	*/
+	inline const std::uint8_t chooseMove(const KeyType& currentBoard, const typename BoardT::BitboardType& ownPieces, const typename BoardT::BitboardType& occupied) {
+		const Telemetry::ScopedTimer timer(telemetry, Telemetry::Timer::MAKE_MOVE);
+		const PriorityList currentPriorities = findPriorities(currentBoard);
 
-		//Save this board in the list
-		boardsFoundInGame.emplace_back(board.getBoard());
+		//The moves to choose between, which the tactics narrow down to a win, a block or the moves that do not lose at once
+		const std::uint8_t allowedMoves = tacticsEnabled ? tacticalMoves(ownPieces, occupied) : currentPriorities.legalMoves;
 
-		//Sum all of the priority values of the moves that can be made at this point
+		//Sum all of the priority values, keeping the running total for each column so a column can be picked without a second pass
+		//Impossible moves always have a priority of 0, so every column can be summed without checking which moves are legal
+		std::array<std::uint16_t, BoardT::NUM_COLS> runningTotals;
 		std::uint16_t sum = 0;
-		for (auto& priority : movePriorities.at(board.getBoard())) {
-			auto currentPriorityVal = priority.second;
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			sum += currentPriorities.priorities[col] * ((allowedMoves >> col) & 1);
+			runningTotals[col] = sum;
+		}
 
-			sum += static_cast<std::uint16_t>(currentPriorityVal);
+		if (sum == 0) {
+			//Every allowed move has been learned to lose, so any of them is as good as another
+			for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+				sum += (allowedMoves >> col) & 1;
+				runningTotals[col] = sum;
+			}
 		}
 
 		//Generate a random number between 1 and the total sum of the priority values
-		const std::uint16_t columnChoice = Random::nextInt(static_cast<std::uint16_t>(1), sum);
-
-		//Convert this random number into a column
-		/*First, we need to declare a variable to hold the current sum of priorities as we move through the map to ensure we pick
-		the correct column*/
-		std::uint16_t currentPriority = 0;
-
-		//Get the selected move
-		for (auto& priority : movePriorities.at(board.getBoard())) {
-			const auto indexOfChosenMove = priority.first;
-			const auto currentPriorityVal = priority.second;
-
-			currentPriority += currentPriorityVal;
-
-			if (currentPriority >= columnChoice) {
-				//The column choice is between the last priority value and the current priority value, so this is the column we choose
-				board.addPiece(indexOfChosenMove, pieceBeingUsed);
-				//Save this move in the list
-				indicesOfMoves.emplace_back(indexOfChosenMove);
-				return indexOfChosenMove;
-			}
+		const std::uint16_t columnChoice = static_cast<std::uint16_t>(random.nextInt(1, sum));
+
+		//The chosen column is the first one whose running total reaches the random number, which is the number of running totals below it
+		std::uint8_t indexOfChosenMove = 0;
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			indexOfChosenMove += runningTotals[col] < columnChoice;
 		}
 
-		//An error occurred, as no move was selected
-		return -1;
+		return indexOfChosenMove;
+	}
+
+	/*
+	Starts loading the priorities of the given board from memory, so that choosing a move on it soon after does not have to wait for them
+	@param key The key of the board
+	*/
+	inline void prefetchPriorities(const KeyType& key) const {
+		if (frozenModel == nullptr) {
+			movePriorities->prefetch(key);
+		}
 	}
 
 	/*
 	Modifies the priority values of all of the moves used during this game based upon whether the AI won or not
 	*/
 	inline void learnFromGame(const std::uint8_t& turnsTaken, const bool& won) {
+		learnFromTrajectory(currentGame, turnsTaken, won);
+
+		//Clear the game storage
+		currentGame.clear();
+	}
+
+	/*
+	Modifies the priority values of all of the moves of a game that was kept by the caller, such as one of a batch of games played with chooseMove
+	@param game The boards this AI moved on and the moves it chose
+	@param turnsTaken The number of moves the first player made in the game
+	@param won true if this AI won the game
+	*/
+	inline void learnFromTrajectory(const Trajectory& game, const std::uint8_t& turnsTaken, const bool& won) {
+		const Telemetry::ScopedTimer timer(telemetry, Telemetry::Timer::LEARN_FROM_GAME);
+
+		if (game.length == 0) {
+			//The AI has not moved this game, so there is nothing to learn
+			return;
+		}
+
 		//Calculate the value to be added to/subtracted from the priority values
 		const std::uint16_t valueModifier = std::max(SPEED_PRIORITY_MODIFIER / turnsTaken, 1);
 
 		if (won) {
 			//We are adding to the priority values
 			//Loop through every priority value except the very last
-			for (auto x = 0; x < boardsFoundInGame.size() - 1; x++) {
-				//Define a pointer to the value being modified for clarity
-				std::uint8_t* priorityValueBeingModified = &movePriorities.at(boardsFoundInGame.at(x)).at(indicesOfMoves.at(x));
-
-				if (MAX_PRIORITY_VALUE - valueModifier < *priorityValueBeingModified) {
-					*priorityValueBeingModified = MAX_PRIORITY_VALUE;
-				}
-				else {
-					*priorityValueBeingModified += valueModifier;
-				}
-			}
-
-			//Define this expression as the last move priority list for clarity
-			auto *lastMovePriorityList = &movePriorities.at(boardsFoundInGame.at(boardsFoundInGame.size() - 1));
+			for (std::uint8_t x = 0; x < game.length - 1; x++) {
+				updatePriorities(game.boards[x], [&](PriorityList& priorityList) {
+					//Define a reference to the value being modified for clarity
+					std::uint8_t& priorityValueBeingModified = priorityList.priorities[game.moves[x]];
 
-			//All moves other than the move chosen potentially miss out on winning the game, so set their priority values to 0
-			for (auto it = lastMovePriorityList->begin(); it != lastMovePriorityList->end(); ++it) {
-				//Use the iterator to set the priority value to 0
-				it->second = 0;
+					if (MAX_PRIORITY_VALUE - valueModifier < priorityValueBeingModified) {
+						priorityValueBeingModified = MAX_PRIORITY_VALUE;
+					}
+					else {
+						priorityValueBeingModified += valueModifier;
+					}
+				});
 			}
 
-			//Set the priority value of the winning move to the maximum
-			lastMovePriorityList->at(indicesOfMoves.at(indicesOfMoves.size() - 1)) = MAX_PRIORITY_VALUE;
+			updatePriorities(game.boards[game.length - 1], [&](PriorityList& lastMovePriorityList) {
+				//All moves other than the move chosen potentially miss out on winning the game, so set their priority values to 0
+				lastMovePriorityList.priorities.fill(0);
 
-			//Clear the game storage vectors
-			boardsFoundInGame.clear();
-			boardsFoundInGame.shrink_to_fit();
-			indicesOfMoves.clear();
-			indicesOfMoves.shrink_to_fit();
+				//Set the priority value of the winning move to the maximum
+				lastMovePriorityList.priorities[game.moves[game.length - 1]] = MAX_PRIORITY_VALUE;
+			});
 		}
 		else {
 			//We are subtracting from the priority values
 			//Loop through every priority value except the very last
-			for (auto x = 0; x < boardsFoundInGame.size() - 1; x++) {
-				//Define a pointer to the value being modified for clarity
-				std::uint8_t* priorityValueBeingModified = &movePriorities.at(boardsFoundInGame.at(x)).at(indicesOfMoves.at(x));
+			for (std::uint8_t x = 0; x < game.length - 1; x++) {
+				updatePriorities(game.boards[x], [&](PriorityList& priorityList) {
+					//Define a reference to the value being modified for clarity
+					std::uint8_t& priorityValueBeingModified = priorityList.priorities[game.moves[x]];
 
-				if (valueModifier >= *priorityValueBeingModified) {
-					*priorityValueBeingModified = 1;
-				}
-				else {
-					*priorityValueBeingModified -= valueModifier;
-				}
+					if (valueModifier >= priorityValueBeingModified) {
+						priorityValueBeingModified = 1;
+					}
+					else {
+						priorityValueBeingModified -= valueModifier;
+					}
+				});
 			}
 
 			//The last move caused a loss, so we set that priority value to 0
-			auto* lastMovePriorityValue = &movePriorities.at(boardsFoundInGame.at(boardsFoundInGame.size() - 1)).at(indicesOfMoves.at(indicesOfMoves.size() - 1));
-			lastMovePriorityValue = 0;
+			updatePriorities(game.boards[game.length - 1], [&](PriorityList& lastMovePriorityList) {
+				lastMovePriorityList.priorities[game.moves[game.length - 1]] = 0;
+			});
 
 			//Now, we need to check if every single move on the final board of the game causes a loss
-			for (auto x = boardsFoundInGame.size() - 1; x >= 1; x--) {
-				bool allZeros = true;
+			for (std::uint8_t x = game.length - 1; x >= 1; x--) {
+				const KeyType lastBoard = game.boards[x];
 
-				//Define a pointer to the priority list of the last move for clarity
-				auto *lastMovePriorityList = &movePriorities.at(boardsFoundInGame.at(x));
+				//Erase the board from memory if every move from it has been learned to lose
+				const bool allZeros = movePriorities->withShard(lastBoard, [&](typename DataType::TableType& table) {
+					const PriorityList* lastMovePriorityList = table.find(lastBoard);
 
-				for (auto it = lastMovePriorityList->begin(); it != lastMovePriorityList->end(); ++it) {
-					if (it->second != 0) {
-						allZeros = false;
-						break;
+					if (lastMovePriorityList == nullptr) {
+						//Another thread has already erased this board
+						return false;
+					}
+
+					std::uint8_t combinedPriorities = 0;
+					for (auto& priority : lastMovePriorityList->priorities) {
+						combinedPriorities |= priority;
 					}
-				}
+
+					if (combinedPriorities != 0 || !table.erase(lastBoard)) {
+						return false;
+					}
+
+					movePriorities->markChanged(lastBoard);
+					Telemetry::count(telemetry, Telemetry::Counter::ERASED_BOARDS);
+					return true;
+				});
 
 				if (allZeros) {
 					//Set the priority of the move that caused us to arrive at the board that guarantees a loss to 0
-					movePriorities.at(boardsFoundInGame.at(x - 1)).at(indicesOfMoves.at(x - 1)) = 0;
-
-					//Erase the board from memory
-					movePriorities.erase(boardsFoundInGame.at(x));
+					updatePriorities(game.boards[x - 1], [&](PriorityList& priorityList) {
+						priorityList.priorities[game.moves[x - 1]] = 0;
+					});
 				}
 				else {
 					break;
 				}
 			}
-
-			//Clear the game storage vectors
-			boardsFoundInGame.clear();
-			boardsFoundInGame.shrink_to_fit();
-			indicesOfMoves.clear();
-			indicesOfMoves.shrink_to_fit();
 		}
 	}
 
@@ -177,39 +302,210 @@ public:
 	Ends the current game without teaching the AI anything
 	*/
 	inline void endCurrentGame() {
-		//Clear the game storage vectors
-		boardsFoundInGame.clear();
-		boardsFoundInGame.shrink_to_fit();
-		indicesOfMoves.clear();
-		indicesOfMoves.shrink_to_fit();
+		//Clear the game storage
+		currentGame.clear();
 	}
 
 	/*
 	Takes learned data in the proper format and remembers it
 	@param data The data to be remembered
 	*/
-	void rememberData(const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>>& data);
+	void rememberData(const DataType& data);
 
 	/*
 	Returns the learned data
-	@return std::map<std::array<std::array<std::int8_t, 7>, 6>, std::map<std::uint8_t, std::uint32_t>> The data
+	@return DataType The data
+	*/
+	const DataType getData() const;
+
+	/*
+	Returns the learned data so that other AI objects can learn into it too
+	@return std::shared_ptr<DataType> The data
+	*/
+	inline const std::shared_ptr<DataType>& getSharedData() const { return movePriorities; }
+
+	/*
+	Makes the AI choose its moves from the given model instead of its learned data
+	Boards missing from the model start with the usual priorities, and nothing is ever added to the learned data, so learning has no effect while a model is used
+	@param model The model to use, or nullptr to go back to the learned data
+	*/
+	inline void useFrozenModel(const std::shared_ptr<const FrozenModel<BoardT>>& model) { frozenModel = model; }
+
+	/*
+	Makes the AI always take a winning move, block the opponent's winning move and avoid moves that let the opponent win straight away
+	The learned priorities still choose between the moves that are left, and every move is learned from as usual
+	@param enabled true to check the tactics before every move
+	*/
+	inline void useTactics(const bool& enabled) { tacticsEnabled = enabled; }
+
+	inline const bool usesTactics() const { return tacticsEnabled; }
+
+	/*
+	Makes the AI count the boards it adds and time its moves and learning, which only the thread playing its games may do
+	@param stats The counters of the thread this AI plays on, which must outlive the AI, or nullptr to stop counting
+	*/
+	inline void useTelemetry(Telemetry::ThreadStats* stats) { telemetry = stats; }
+
+	/*
+	Caps the memory of the learned data, which is shared with every AI learning into it
+	Once the cap is reached, boards that have not been used for the longest are forgotten to make room for new ones
+	Boards beyond the cap are forgotten straight away
+	@param bytes The most memory the learned data may use, or 0 for no limit
 	*/
-	const std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>> getData() const;
+	void setMemoryLimit(const std::size_t& bytes);
+
+	/*
+	Forgets boards until the learned data is within its memory limit, such as after reading a data file
+	*/
+	void trimToMemoryLimit();
 
 private:
-	//This maps boards with certain combinations of pieces on the board to a mapping of columns to move priorities
-	std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>> movePriorities;
+	//This maps the keys of boards with certain combinations of pieces on the board to a mapping of columns to move priorities
+	//It can be shared between AI objects that play on different threads
+	std::shared_ptr<DataType> movePriorities;
 
-	//Collectively, these two vectors store all of the board statuses and the index of the move chosen for this game
-	std::vector<Board::BoardType> boardsFoundInGame;
-	std::vector<std::uint8_t> indicesOfMoves;
+	//Stores the keys of all of the board statuses and the index of the move chosen for this game
+	Trajectory currentGame;
+
+	//Used in place of movePriorities when set, such as when playing against a person
+	std::shared_ptr<const FrozenModel<BoardT>> frozenModel;
 
 	//Stores the piece this AI is playing with
 	std::int8_t pieceBeingUsed;
 
+	//Used to pick between moves based on their priorities
+	Random random;
+
+	//Set to check for wins and threats before choosing from the priorities (see useTactics)
+	bool tacticsEnabled = false;
+
+	//The counters of the thread this AI plays on, or nullptr if nothing is counted (see useTelemetry)
+	Telemetry::ThreadStats* telemetry = nullptr;
+
+	/*
+	Returns the moves worth choosing between on the given board, found from the spaces that would complete a line for either player
+	@param ownPieces The bitboard of this AI's pieces, where it must be this AI's turn
+	@param occupied The bitboard of every piece on the board
+	@return std::uint8_t Bit n is set if column n may be played
+	*/
+	static inline std::uint8_t tacticalMoves(const typename BoardT::BitboardType& ownPieces, const typename BoardT::BitboardType& occupied) {
+		const typename BoardT::BitboardType playable = (occupied + BoardT::BOTTOM_MASK) & BoardT::BOARD_MASK;
+
+		const typename BoardT::BitboardType wins = BoardT::winningSpaces(ownPieces, occupied) & playable;
+		if (wins) {
+			return columnsOf(wins);
+		}
+
+		const typename BoardT::BitboardType threats = BoardT::winningSpaces(occupied ^ ownPieces, occupied);
+
+		//Any block is as good as another, since the game is lost anyway if there is more than one threat to block
+		const typename BoardT::BitboardType blocks = threats & playable;
+		if (blocks) {
+			return columnsOf(blocks);
+		}
+
+		//Playing directly below one of the opponent's winning spaces lets them play there next
+		const typename BoardT::BitboardType safe = playable & ~(threats >> 1);
+		return columnsOf(safe ? safe : playable);
+	}
+
 	/*
-	Initializes a new portion of the movePriorities map if the given board situation has never been seen by the AI before
-	@param board The unknown board
+	Returns the columns that hold any of the given spaces
+	@param spaces A bitboard
+	@return std::uint8_t Bit n is set if column n holds one of the spaces
 	*/
-	void initPriorities(Board& board);
+	static inline std::uint8_t columnsOf(const typename BoardT::BitboardType& spaces) {
+		std::uint8_t columns = 0;
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			columns |= static_cast<std::uint8_t>((spaces & BoardT::COL_MASKS[col]) != 0) << col;
+		}
+
+		return columns;
+	}
+
+	/*
+	Generates the starting priority list of a board situation the AI has never seen before
+	@param key The key of the unknown board
+	@return PriorityList The starting priorities of every move on the board
+	*/
+	static PriorityList initPriorities(const KeyType& key);
+
+	/*
+	Returns the priorities of the given board, adding the board to the learned data if it has never been seen
+	The priorities are copied, since other threads may change the table afterwards
+	@param key The key of the board
+	@return PriorityList The priorities of every move on the board
+	*/
+	inline PriorityList findPriorities(const KeyType& key) {
+		if (frozenModel != nullptr) {
+			PriorityList priorities;
+
+			if (!frozenModel->find(key, priorities.priorities)) {
+				return initPriorities(key);
+			}
+
+			priorities.legalMoves = BoardT::legalMovesOfKey(key);
+			priorities.visits = 0;
+			return priorities;
+		}
+
+		//Make sure the table has a key equal to this board
+		return movePriorities->withShard(key, [&](typename DataType::TableType& table) {
+			PriorityList* priorities = table.find(key);
+
+			if (priorities == nullptr) {
+				//Make room for the board by forgetting boards that have not been used recently
+				Telemetry::count(telemetry, Telemetry::Counter::EVICTED_BOARDS, movePriorities->makeRoomFor(key, isStillUsed));
+
+				//Initialize the priority list
+				priorities = table.emplace(key, initPriorities(key)).first;
+				movePriorities->markChanged(key);
+				Telemetry::count(telemetry, Telemetry::Counter::NEW_BOARDS);
+			}
+
+			if (movePriorities->isLimited() && priorities->visits < MAX_VISITS) {
+				priorities->visits++;
+			}
+
+			return *priorities;
+		});
+	}
+
+	/*
+	Decides whether a board is kept as the eviction clock passes it, taking away one of its visits if it has any left
+	Only the visits decide, so the key the clock passes along with them is not needed
+	@param priorityList The priorities of the board
+	@return bool true if the board has been used since the clock last passed it
+	*/
+	static inline bool isStillUsed(const KeyType&, PriorityList& priorityList) {
+		if (priorityList.visits == 0) {
+			return false;
+		}
+
+		priorityList.visits--;
+		return true;
+	}
+
+	/*
+	Calls the given function with the priority list of the given board while no other thread can change it
+	Nothing happens if the board is not in the table, which is the case if another thread erased it or, under a memory limit, if it was evicted since the game moved on it
+	That learning is lost, so it is counted as a dropped update
+	@param key The key of the board
+	@param function Called with the PriorityList& of the board
+	*/
+	template <class Function>
+	inline void updatePriorities(const KeyType& key, Function function) {
+		movePriorities->withShard(key, [&](typename DataType::TableType& table) {
+			PriorityList* priorityList = table.find(key);
+
+			if (priorityList == nullptr) {
+				Telemetry::count(telemetry, Telemetry::Counter::DROPPED_UPDATES);
+				return;
+			}
+
+			function(*priorityList);
+			movePriorities->markChanged(key);
+		});
+	}
 };
\ No newline at end of file
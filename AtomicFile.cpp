@@ -0,0 +1,173 @@
+#include "AtomicFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <io.h>
+#include <process.h>
+#include <sys/stat.h>
+#include <windows.h>
+
+namespace
+{
+	inline int openExclusive(const std::string& name) { return _open(name.c_str(), _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE); }
+	inline int openAppend(const std::string& name) { return _open(name.c_str(), _O_CREAT | _O_APPEND | _O_WRONLY | _O_BINARY, _S_IREAD | _S_IWRITE); }
+	inline long long endOf(const int& file) { return _lseeki64(file, 0, SEEK_END); }
+	inline long long writeSome(const int& file, const char* data, const std::size_t& size) { return _write(file, data, static_cast<unsigned int>(std::min<std::size_t>(size, 1u << 30))); }
+	inline bool seekTo(const int& file, const std::uint64_t& offset) { return _lseeki64(file, static_cast<long long>(offset), SEEK_SET) >= 0; }
+	inline bool syncFile(const int& file) { return _commit(file) == 0; }
+	inline void closeFile(const int& file) { _close(file); }
+	inline unsigned long processId() { return static_cast<unsigned long>(_getpid()); }
+
+	inline bool replaceFile(const std::string& from, const std::string& to) {
+		return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+	}
+}
+#else
+#include <unistd.h>
+
+namespace
+{
+	inline int openExclusive(const std::string& name) { return ::open(name.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644); }
+	inline int openAppend(const std::string& name) { return ::open(name.c_str(), O_CREAT | O_APPEND | O_WRONLY, 0644); }
+	inline long long endOf(const int& file) { return lseek(file, 0, SEEK_END); }
+	inline long long writeSome(const int& file, const char* data, const std::size_t& size) { return ::write(file, data, size); }
+	inline bool seekTo(const int& file, const std::uint64_t& offset) { return lseek(file, static_cast<off_t>(offset), SEEK_SET) >= 0; }
+	inline bool syncFile(const int& file) { return fsync(file) == 0; }
+	inline void closeFile(const int& file) { ::close(file); }
+	inline unsigned long processId() { return static_cast<unsigned long>(getpid()); }
+
+	inline bool replaceFile(const std::string& from, const std::string& to) {
+		if (std::rename(from.c_str(), to.c_str()) != 0) {
+			return false;
+		}
+
+		//Flush the directory too, so the rename itself survives a crash
+		const std::size_t slash = to.find_last_of('/');
+		const std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : to.substr(0, slash));
+		const int directoryFile = ::open(directory.c_str(), O_RDONLY);
+
+		if (directoryFile >= 0) {
+			fsync(directoryFile);
+			::close(directoryFile);
+		}
+
+		return true;
+	}
+}
+#endif
+
+AtomicFile::AtomicFile(const std::string& filename)
+	: filename(filename), file(-1), failed(false)
+{
+	//Counts the temporary files made by this process, so names never repeat even within one process
+	static std::atomic<unsigned int> tempFilesMade(0);
+
+	//Another program may have left a file with the same name behind, so keep trying new names for a while
+	for (unsigned int attempt = 0; attempt < 100 && file < 0; attempt++) {
+		tempFilename = filename + ".tmp." + std::to_string(processId()) + "." + std::to_string(tempFilesMade++);
+		file = openExclusive(tempFilename);
+	}
+}
+
+AtomicFile::~AtomicFile()
+{
+	abort();
+}
+
+bool AtomicFile::write(const char* data, const std::size_t& size)
+{
+	for (std::size_t written = 0; isOpen() && written < size;) {
+		const long long result = writeSome(file, data + written, size - written);
+
+		if (result <= 0) {
+			failed = true;
+			break;
+		}
+
+		written += static_cast<std::size_t>(result);
+	}
+
+	return isOpen();
+}
+
+bool AtomicFile::writeAt(const std::uint64_t& offset, const char* data, const std::size_t& size)
+{
+	if (isOpen() && !seekTo(file, offset)) {
+		failed = true;
+	}
+
+	return write(data, size);
+}
+
+bool AtomicFile::commit()
+{
+	if (!isOpen() || !syncFile(file)) {
+		abort();
+		return false;
+	}
+
+	closeFile(file);
+	file = -1;
+
+	if (!replaceFile(tempFilename, filename)) {
+		std::remove(tempFilename.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+void AtomicFile::abort()
+{
+	if (file >= 0) {
+		closeFile(file);
+		file = -1;
+		std::remove(tempFilename.c_str());
+	}
+}
+
+AppendFile::AppendFile(const std::string& filename)
+	: file(openAppend(filename)), failed(false)
+{}
+
+AppendFile::~AppendFile()
+{
+	if (file >= 0) {
+		closeFile(file);
+	}
+}
+
+std::uint64_t AppendFile::size() const
+{
+	const long long end = file >= 0 ? endOf(file) : -1;
+	return end > 0 ? static_cast<std::uint64_t>(end) : 0;
+}
+
+bool AppendFile::write(const char* data, const std::size_t& size)
+{
+	for (std::size_t written = 0; isOpen() && written < size;) {
+		const long long result = writeSome(file, data + written, size - written);
+
+		if (result <= 0) {
+			failed = true;
+			break;
+		}
+
+		written += static_cast<std::size_t>(result);
+	}
+
+	return isOpen();
+}
+
+bool AppendFile::sync()
+{
+	if (isOpen() && !syncFile(file)) {
+		failed = true;
+	}
+
+	return isOpen();
+}
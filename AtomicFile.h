@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/*
+Writes a file so that it is either completely replaced or left untouched
+Data goes to a uniquely named temporary file next to the target, which is flushed to the disk and then renamed over the target
+Several programs can save the same file at once without writing into each other's temporary files
+*/
+class AtomicFile
+{
+public:
+	/*
+	Creates the temporary file for the given target
+	@param filename The file to replace once the data has been written
+	*/
+	AtomicFile(const std::string& filename);
+
+	/*
+	Deletes the temporary file if commit was never called
+	*/
+	~AtomicFile();
+
+	AtomicFile(const AtomicFile&) = delete;
+	AtomicFile& operator=(const AtomicFile&) = delete;
+
+	/*
+	Returns true if the temporary file was created and every write so far has succeeded
+	@return bool true if the file can still be committed
+	*/
+	inline const bool isOpen() const { return file >= 0 && !failed; }
+
+	/*
+	Writes the given bytes after everything written so far
+	Large writes are handed to the operating system as they are, so callers should gather data into big blocks
+	@param data The bytes to write
+	@param size The number of bytes
+	@return bool true if every byte was written or false otherwise
+	*/
+	bool write(const char* data, const std::size_t& size);
+
+	/*
+	Overwrites bytes that have already been written, such as a header that depends on the rest of the file
+	@param offset The position of the first byte from the start of the file
+	@param data The bytes to write
+	@param size The number of bytes
+	@return bool true if every byte was written or false otherwise
+	*/
+	bool writeAt(const std::uint64_t& offset, const char* data, const std::size_t& size);
+
+	/*
+	Flushes the temporary file to the disk and renames it over the target
+	@return bool true if the target now holds the new data or false if it still holds the old data
+	*/
+	bool commit();
+
+	inline const std::string& getFilename() const { return filename; }
+	inline const std::string& getTempFilename() const { return tempFilename; }
+
+private:
+	std::string filename;
+	std::string tempFilename;
+
+	//The descriptor of the temporary file, or -1 once it is closed
+	int file;
+
+	//Set once any write fails, after which the file can never be committed
+	bool failed;
+
+	/*
+	Closes and deletes the temporary file
+	*/
+	void abort();
+};
+
+/*
+Adds data to the end of a file, flushing it to the disk whenever asked so that everything added before is kept after a crash
+*/
+class AppendFile
+{
+public:
+	/*
+	Opens the given file for appending, creating it if it does not exist
+	@param filename The file to append to
+	*/
+	AppendFile(const std::string& filename);
+
+	~AppendFile();
+
+	AppendFile(const AppendFile&) = delete;
+	AppendFile& operator=(const AppendFile&) = delete;
+
+	/*
+	Returns true if the file was opened and every write so far has succeeded
+	@return bool true if the file can still be appended to
+	*/
+	inline const bool isOpen() const { return file >= 0 && !failed; }
+
+	/*
+	Returns the size of the file, which is where the next write will go
+	@return std::uint64_t The size of the file in bytes
+	*/
+	std::uint64_t size() const;
+
+	/*
+	Writes the given bytes to the end of the file
+	@param data The bytes to write
+	@param size The number of bytes
+	@return bool true if every byte was written or false otherwise
+	*/
+	bool write(const char* data, const std::size_t& size);
+
+	/*
+	Flushes everything written so far to the disk
+	@return bool true if the data is on the disk or false otherwise
+	*/
+	bool sync();
+
+private:
+	//The descriptor of the file, or -1 if it could not be opened
+	int file;
+
+	//Set once any write fails
+	bool failed;
+};
@@ -0,0 +1,353 @@
+#include "Benchmark.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include "FileManager.h"
+#include "Solver.h"
+#include "Trainer.h"
+
+template <class BoardT>
+Benchmark<BoardT>::Benchmark(const std::uint64_t& seed, const unsigned int& numThreads, const std::string& tempFilename)
+	: seed(seed), numThreads(numThreads), tempFilename(tempFilename), seeds(seed), sink(0)
+{}
+
+template <class BoardT>
+void Benchmark<BoardT>::run(const std::string& boardName, std::ostream& output)
+{
+	results.clear();
+
+	std::cerr << "Benchmarking the board...\n";
+	benchmarkAddPiece();
+	benchmarkCheckForWin();
+	benchmarkDropPieces();
+
+	std::cerr << "Benchmarking self-play...\n";
+	AI<BoardT> ai1(BoardT::YELLOW_PIECE, seeds.next());
+	AI<BoardT> ai2(BoardT::RED_PIECE, seeds.next());
+	benchmarkSelfPlay(ai1, ai2, 1);
+
+	if (numThreads > 1) {
+		//Train copies so the single threaded data is the same no matter how many threads there are
+		AI<BoardT> threadedAI1(BoardT::YELLOW_PIECE, ai1.getData());
+		AI<BoardT> threadedAI2(BoardT::RED_PIECE, ai2.getData());
+		benchmarkSelfPlay(threadedAI1, threadedAI2, numThreads);
+	}
+
+	//Playing many games at once is timed on copies too, since its games are learned from in a different order
+	AI<BoardT> batchedAI1(BoardT::YELLOW_PIECE, ai1.getData());
+	AI<BoardT> batchedAI2(BoardT::RED_PIECE, ai2.getData());
+	benchmarkSelfPlay(batchedAI1, batchedAI2, 1, BATCH_SIZE);
+
+	std::cerr << "Benchmarking the AI...\n";
+	benchmarkMakeMove(ai1, ai2, "ai_make_move");
+
+	//The same games again with the threat checks, to show what they cost per move
+	ai1.useTactics(true);
+	ai2.useTactics(true);
+	benchmarkMakeMove(ai1, ai2, "ai_make_move_tactics");
+	ai1.useTactics(false);
+	ai2.useTactics(false);
+	benchmarkLearnFromGame(ai1, ai2);
+
+	std::cerr << "Benchmarking the data files...\n";
+	benchmarkFiles(ai1);
+
+	std::cerr << "Benchmarking the solver...\n";
+	benchmarkSolver();
+
+	std::cerr << "Benchmarking Monte Carlo search...\n";
+	benchmarkSearch(1, MonteCarloSearch<BoardT>::Parallelism::TREE, "mcts_playouts");
+
+	if (numThreads > 1) {
+		benchmarkSearch(numThreads, MonteCarloSearch<BoardT>::Parallelism::TREE, "mcts_tree_playouts_threaded");
+		benchmarkSearch(numThreads, MonteCarloSearch<BoardT>::Parallelism::ROOT, "mcts_root_playouts_threaded");
+	}
+
+	output << std::setprecision(6) << "{\"board\":\"" << boardName << "\",\"seed\":" << seed << ",\"threads\":" << numThreads << ",\"results\":[";
+
+	for (std::size_t x = 0; x < results.size(); x++) {
+		output << (x == 0 ? "" : ",") << "\n{\"name\":\"" << results[x].name << "\",\"unit\":\"" << results[x].unit
+			<< "\",\"value\":" << results[x].value << ",\"iterations\":" << results[x].iterations << "}";
+	}
+
+	output << "\n]}" << std::endl;
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkAddPiece()
+{
+	Random random(seeds.next());
+	BoardT board;
+
+	//Pick the columns before timing so the random number generator is not part of the result
+	std::vector<std::uint8_t> columns(MICRO_ITERATIONS);
+	for (auto& col : columns) {
+		col = static_cast<std::uint8_t>(random.nextBelow(BoardT::NUM_COLS));
+	}
+
+	std::uint64_t added = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::uint64_t x = 0; x < MICRO_ITERATIONS; x++) {
+		if (board.addPiece(columns[x], static_cast<int>(x & 1))) {
+			added++;
+		}
+		else {
+			board.clearBoard();
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	sink = added;
+
+	addResult("board_add_piece", "ns/op", seconds * 1e9 / MICRO_ITERATIONS, MICRO_ITERATIONS);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkCheckForWin()
+{
+	//The number of different positions to check, which is small enough to stay in the cache
+	const std::size_t numPositions = 4096;
+
+	Random random(seeds.next());
+	std::vector<BoardT> boards;
+	std::vector<std::uint8_t> lastMoves;
+	boards.reserve(numPositions);
+	lastMoves.reserve(numPositions);
+
+	//Take positions from random games, stopping each game at its first win
+	BoardT board;
+	int type = BoardT::YELLOW_PIECE;
+	while (boards.size() < numPositions) {
+		const std::uint8_t col = static_cast<std::uint8_t>(random.nextBelow(BoardT::NUM_COLS));
+
+		if (!board.addPiece(col, type)) {
+			continue;
+		}
+
+		boards.push_back(board);
+		lastMoves.push_back(col);
+		type = type == BoardT::YELLOW_PIECE ? BoardT::RED_PIECE : BoardT::YELLOW_PIECE;
+
+		if (board.checkForWin(col) || board.isFull()) {
+			board.clearBoard();
+			type = BoardT::YELLOW_PIECE;
+		}
+	}
+
+	std::uint64_t wins = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::uint64_t x = 0; x < MICRO_ITERATIONS; x++) {
+		const std::size_t index = x & (numPositions - 1);
+		wins += boards[index].checkForWin(lastMoves[index]);
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	sink = wins;
+
+	addResult("board_check_for_win", "ns/op", seconds * 1e9 / MICRO_ITERATIONS, MICRO_ITERATIONS);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkDropPieces()
+{
+	Random random(seeds.next());
+	BoardBatch<BoardT> boards(BATCH_SIZE);
+
+	//Random columns that are played in every game, which fill the boards quickly enough that every outcome is reached
+	std::vector<std::uint8_t> columns(boards.size() * 64);
+	for (auto& col : columns) {
+		col = static_cast<std::uint8_t>(random.nextBelow(BoardT::NUM_COLS));
+	}
+
+	std::vector<typename BoardBatch<BoardT>::Outcome> outcomes(boards.size());
+	const std::uint64_t steps = MICRO_ITERATIONS / boards.size();
+	std::uint64_t finished = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::uint64_t step = 0; step < steps; step++) {
+		boards.dropPieces(&columns[(step & 63) * boards.size()], outcomes.data());
+
+		for (std::size_t game = 0; game < boards.size(); game++) {
+			if (outcomes[game] != BoardBatch<BoardT>::Outcome::ONGOING) {
+				boards.clearBoard(game);
+				finished++;
+			}
+		}
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	sink = finished;
+
+	addResult("board_batch_drop_pieces", "ns/op", seconds * 1e9 / (steps * boards.size()), steps * boards.size());
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkSelfPlay(AI<BoardT>& ai1, AI<BoardT>& ai2, const unsigned int& threads, const std::size_t& batchSize)
+{
+	Trainer<BoardT> trainer(ai1, ai2, threads, seeds.next());
+	trainer.setBatchSize(batchSize);
+	const std::atomic<bool> stop(false);
+
+	const auto trainingResults = trainer.train(TRAINING_GAMES, stop);
+
+	addResult(std::string(batchSize > 1 ? "self_play_batched_" : "self_play_") + std::to_string(threads) + "_thread", "games/s",
+		trainingResults.gamesPerSecond(), trainingResults.gamesPlayed);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkMakeMove(AI<BoardT>& ai1, AI<BoardT>& ai2, const std::string& name)
+{
+	BoardT board;
+	std::uint64_t moves = 0;
+	const auto start = std::chrono::steady_clock::now();
+
+	for (std::uint64_t game = 0; game < GAME_ITERATIONS; game++) {
+		board.clearBoard();
+
+		while (true) {
+			moves++;
+			if (board.checkForWin(ai1.makeMove(board)) || board.isFull()) {
+				break;
+			}
+
+			moves++;
+			if (board.checkForWin(ai2.makeMove(board)) || board.isFull()) {
+				break;
+			}
+		}
+
+		//Forget the game so every game is played on the same data
+		ai1.endCurrentGame();
+		ai2.endCurrentGame();
+	}
+
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	addResult(name, "ns/op", seconds * 1e9 / moves, moves);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkLearnFromGame(const AI<BoardT>& ai1, const AI<BoardT>& ai2)
+{
+	//Learning changes the data, so learn into copies of it
+	AI<BoardT> learner1(BoardT::YELLOW_PIECE, seeds.next());
+	AI<BoardT> learner2(BoardT::RED_PIECE, seeds.next());
+	learner1.rememberData(ai1.getData());
+	learner2.rememberData(ai2.getData());
+
+	BoardT board;
+	std::uint64_t lessons = 0;
+	std::chrono::steady_clock::duration learning(0);
+
+	for (std::uint64_t game = 0; game < GAME_ITERATIONS; game++) {
+		std::uint8_t numMoves = 0;
+		int winner = BoardT::NO_PIECE;
+		board.clearBoard();
+
+		while (true) {
+			numMoves++;
+			if (board.checkForWin(learner1.makeMove(board))) {
+				winner = BoardT::YELLOW_PIECE;
+				break;
+			}
+			if (board.isFull()) {
+				break;
+			}
+
+			if (board.checkForWin(learner2.makeMove(board))) {
+				winner = BoardT::RED_PIECE;
+				break;
+			}
+			if (board.isFull()) {
+				break;
+			}
+		}
+
+		if (winner == BoardT::NO_PIECE) {
+			learner1.endCurrentGame();
+			learner2.endCurrentGame();
+			continue;
+		}
+
+		//Only the learning is timed, since the games themselves are covered by the other benchmarks
+		const auto start = std::chrono::steady_clock::now();
+		learner1.learnFromGame(numMoves, winner == BoardT::YELLOW_PIECE);
+		learner2.learnFromGame(numMoves, winner == BoardT::RED_PIECE);
+		learning += std::chrono::steady_clock::now() - start;
+
+		lessons += 2;
+	}
+
+	addResult("ai_learn_from_game", "ns/op", lessons > 0 ? std::chrono::duration<double>(learning).count() * 1e9 / lessons : 0, lessons);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkFiles(AI<BoardT>& ai)
+{
+	FileManager<BoardT> file(tempFilename);
+	const std::size_t entries = ai.getSharedData()->size();
+
+	auto start = std::chrono::steady_clock::now();
+	file.writeAIData(ai);
+	const double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::ifstream written(tempFilename, std::ifstream::binary | std::ifstream::ate);
+	const double megabytes = written.is_open() ? static_cast<double>(written.tellg()) / (1024 * 1024) : 0;
+	written.close();
+
+	AI<BoardT> reader(BoardT::YELLOW_PIECE, seeds.next());
+
+	start = std::chrono::steady_clock::now();
+	file.readAIData(reader);
+	const double readSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::remove(tempFilename.c_str());
+
+	addResult("file_size", "MB", megabytes, entries);
+	addResult("file_write", "MB/s", writeSeconds > 0 ? megabytes / writeSeconds : 0, entries);
+	addResult("file_write_time", "s", writeSeconds, entries);
+	addResult("file_read", "MB/s", readSeconds > 0 ? megabytes / readSeconds : 0, reader.getSharedData()->size());
+	addResult("file_read_time", "s", readSeconds, reader.getSharedData()->size());
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkSolver()
+{
+	Solver<BoardT> solver(BoardT::YELLOW_PIECE, SOLVER_SECONDS);
+	const BoardT board;
+
+	const typename Solver<BoardT>::Result result = solver.solve(board);
+	sink = result.bestMove;
+
+	addResult("solver_search", "positions/s", result.positionsPerSecond(), result.positionsSearched);
+	addResult("solver_depth", "plies", result.depth, result.positionsSearched);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::benchmarkSearch(const unsigned int& searchThreads, const typename MonteCarloSearch<BoardT>::Parallelism& parallelism, const std::string& name)
+{
+	//Every thread gets as many playouts as the single threaded search, so the time is comparable
+	MonteCarloSearch<BoardT> search(BoardT::YELLOW_PIECE, seeds.next(), SEARCH_PLAYOUTS * searchThreads, 0, searchThreads, parallelism);
+	const BoardT board;
+
+	const typename MonteCarloSearch<BoardT>::Result result = search.search(board);
+	sink = result.bestMove;
+
+	addResult(name, "playouts/s", result.playoutsPerSecond(), result.playouts);
+}
+
+template <class BoardT>
+void Benchmark<BoardT>::addResult(const std::string& name, const std::string& unit, const double& value, const std::uint64_t& iterations)
+{
+	results.push_back({ name, unit, value, iterations });
+	std::cerr << "  " << name << ": " << value << " " << unit << "\n";
+}
+
+template class Benchmark<Board4x5>;
+template class Benchmark<Board5x6>;
+template class Benchmark<Board6x7>;
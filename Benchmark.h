@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Board.h"
+#include "AI.h"
+#include "MonteCarloSearch.h"
+#include "Random.h"
+
+/*
+Times the hot parts of the program with repeatable seeds and reports the results as JSON
+@param BoardT The type of board to benchmark
+*/
+template <class BoardT>
+class Benchmark
+{
+public:
+	//The number of calls timed by each micro-benchmark
+	static constexpr std::uint64_t MICRO_ITERATIONS = 4000000;
+
+	//The number of games used to time self-play, which also trains the AI objects used by the other benchmarks
+	static constexpr std::uint64_t TRAINING_GAMES = 200000;
+
+	//The number of games each thread plays at once when timing batched self-play and BoardBatch
+	static constexpr std::size_t BATCH_SIZE = 256;
+
+	//The number of games played to time AI::makeMove and AI::learnFromGame
+	static constexpr std::uint64_t GAME_ITERATIONS = 100000;
+
+	//The longest the solver is given to search the empty board, which is enough to solve the smallest board completely
+	static constexpr double SOLVER_SECONDS = 2;
+
+	//The number of playouts Monte Carlo search makes from the empty board
+	static constexpr std::uint64_t SEARCH_PLAYOUTS = 200000;
+
+	/*
+	The outcome of one benchmark
+	*/
+	struct Result
+	{
+		std::string name;
+		std::string unit;
+		double value;
+		std::uint64_t iterations;
+	};
+
+	/*
+	Prepares the benchmarks
+	@param seed Seeds every random choice so runs can be compared
+	@param numThreads The number of threads used by the multi-threaded self-play and search benchmarks
+	@param tempFilename The file the save and load benchmarks write to, which is deleted afterwards
+	*/
+	Benchmark(const std::uint64_t& seed, const unsigned int& numThreads, const std::string& tempFilename);
+
+	/*
+	Runs every benchmark and writes the results as a JSON object
+	Progress is printed to std::cerr so the output stream only ever holds the JSON
+	@param boardName The name of the board size, which is included in the output
+	@param output The stream to write the JSON to
+	*/
+	void run(const std::string& boardName, std::ostream& output);
+
+private:
+	std::uint64_t seed;
+	unsigned int numThreads;
+	std::string tempFilename;
+
+	//Generates the seed of every board and AI object used by the benchmarks
+	Random seeds;
+
+	std::vector<Result> results;
+
+	//Written to by the benchmarks so the compiler cannot remove the work being timed
+	volatile std::uint64_t sink;
+
+	/*
+	Times Board::addPiece on random columns, clearing the board whenever a move is not possible
+	*/
+	void benchmarkAddPiece();
+
+	/*
+	Times Board::checkForWin on positions taken from random games
+	*/
+	void benchmarkCheckForWin();
+
+	/*
+	Times BoardBatch::dropPieces, including its win and full board checks, per game moved in
+	*/
+	void benchmarkDropPieces();
+
+	/*
+	Times self-play training of the given AI objects, which also gives them data for the other benchmarks
+	@param ai1 The AI that moves first
+	@param ai2 The AI that moves second
+	@param threads The number of threads to train on
+	@param batchSize The number of games each thread plays at once (see Trainer::setBatchSize)
+	*/
+	void benchmarkSelfPlay(AI<BoardT>& ai1, AI<BoardT>& ai2, const unsigned int& threads, const std::size_t& batchSize = 1);
+
+	/*
+	Times AI::makeMove over whole games without learning from them, so the data stays the same throughout
+	@param ai1 The AI that moves first
+	@param ai2 The AI that moves second
+	@param name The name of the result
+	*/
+	void benchmarkMakeMove(AI<BoardT>& ai1, AI<BoardT>& ai2, const std::string& name);
+
+	/*
+	Times AI::learnFromGame on copies of the given AI objects
+	@param ai1 The AI that moves first
+	@param ai2 The AI that moves second
+	*/
+	void benchmarkLearnFromGame(const AI<BoardT>& ai1, const AI<BoardT>& ai2);
+
+	/*
+	Times FileManager::writeAIData and FileManager::readAIData on the data of the given AI
+	@param ai The AI whose data is saved and loaded
+	*/
+	void benchmarkFiles(AI<BoardT>& ai);
+
+	/*
+	Times Solver::solve on the empty board
+	*/
+	void benchmarkSolver();
+
+	/*
+	Times MonteCarloSearch::search on the empty board
+	@param searchThreads The number of threads to search on
+	@param parallelism How the threads share the work
+	@param name The name of the result
+	*/
+	void benchmarkSearch(const unsigned int& searchThreads, const typename MonteCarloSearch<BoardT>::Parallelism& parallelism, const std::string& name);
+
+	/*
+	Records the outcome of a benchmark
+	@param name The name of the benchmark
+	@param unit The unit of the value
+	@param value The measured value
+	@param iterations The number of operations that were timed
+	*/
+	void addResult(const std::string& name, const std::string& unit, const double& value, const std::uint64_t& iterations);
+};
@@ -1,26 +1,26 @@
 #include "Board.h"
 
-Board::Board()
+template <std::uint8_t Rows, std::uint8_t Cols, std::uint8_t ConnectN>
+Board<Rows, Cols, ConnectN>::Board()
 {
-	for (std::uint8_t row = 0; row < board.size(); row++) {
-		for (std::uint8_t col = 0; col < board.at(row).size(); col++) {
-			board.at(row).at(col) = NO_PIECE;
-		}
-	}
+	static_assert(winningKernelMatchesLines(), "The win detection shifts do not match the winning lines of this board");
+
+	clearBoard();
 }
 
-void Board::printBoard() const
+template <std::uint8_t Rows, std::uint8_t Cols, std::uint8_t ConnectN>
+void Board<Rows, Cols, ConnectN>::printBoard() const
 {
 	//Print the column numbers
-	for (size_t x = 1; x <= board.size() + 1; x++) {
+	for (size_t x = 1; x <= NUM_COLS; x++) {
 		std::cout << x << " ";
 	}
 	std::cout << "\n\n";
 
 	//Print all the pieces on the board
-	for (auto& row : board) {
-		for (auto& elem : row) {
-			switch (elem) {
+	for (std::uint8_t row = 0; row < NUM_ROWS; row++) {
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			switch (getPieceUnchecked(row, col)) {
 			case NO_PIECE:
 				std::cout << "- ";
 				break;
@@ -36,4 +36,8 @@ void Board::printBoard() const
 
 		std::cout << "\n";
 	}
-}
\ No newline at end of file
+}
+
+template class Board<4, 5, 4>;
+template class Board<5, 6, 4>;
+template class Board<6, 7, 4>;
@@ -1,18 +1,110 @@
 #pragma once
 #include <iostream>
 #include <array>
-
+#include <cstdint>
+
+/*
+A Connect 4 board with its geometry fixed at compile time
+Every mask and winning line is generated when the template is instantiated, so each board size gets its own specialized code
+@param Rows The number of rows on the board
+@param Cols The number of columns on the board
+@param ConnectN The number of pieces in a row needed to win
+*/
+template <std::uint8_t Rows, std::uint8_t Cols, std::uint8_t ConnectN>
 class Board
 {
 public:
-	static const std::int8_t NO_PIECE = -1;
-	static const std::int8_t RED_PIECE = 0;
-	static const std::int8_t YELLOW_PIECE = 1;
+	static constexpr std::int8_t NO_PIECE = -1;
+	static constexpr std::int8_t RED_PIECE = 0;
+	static constexpr std::int8_t YELLOW_PIECE = 1;
+
+	static constexpr std::uint8_t NUM_ROWS = Rows;
+	static constexpr std::uint8_t NUM_COLS = Cols;
+
+	//The number of pieces in a row needed to win
+	static constexpr std::uint8_t CONNECT_N = ConnectN;
 
-	static const std::uint8_t NUM_ROWS = 4;
-	static const std::uint8_t NUM_COLS = 5;
+	//Each column is stored as NUM_ROWS bits plus one empty sentinel bit on top, starting from the bottom row
+	static constexpr std::uint8_t COL_HEIGHT = NUM_ROWS + 1;
 
 	typedef std::array<std::array<std::int8_t, NUM_COLS>, NUM_ROWS> BoardType;
+	typedef std::uint64_t BitboardType;
+
+	//A position packed into a single integer (see getKey)
+	typedef std::uint64_t KeyType;
+
+	//Returned by dropPiece when the piece could not be added
+	static constexpr std::uint8_t INVALID_SQUARE = UINT8_MAX;
+
+	static_assert(COL_HEIGHT * NUM_COLS <= 64, "The board does not fit within a 64 bit bitboard");
+	static_assert(CONNECT_N >= 2 && (CONNECT_N <= NUM_ROWS || CONNECT_N <= NUM_COLS), "CONNECT_N pieces in a row must fit on the board");
+
+	//The number of different winning lines on the board (horizontal, vertical and both diagonals)
+	static constexpr std::size_t NUM_LINES =
+		(NUM_COLS >= CONNECT_N ? NUM_ROWS * (NUM_COLS - CONNECT_N + 1) : 0) +
+		(NUM_ROWS >= CONNECT_N ? NUM_COLS * (NUM_ROWS - CONNECT_N + 1) : 0) +
+		(NUM_COLS >= CONNECT_N && NUM_ROWS >= CONNECT_N ? 2 * (NUM_ROWS - CONNECT_N + 1) * (NUM_COLS - CONNECT_N + 1) : 0);
+
+	typedef std::array<BitboardType, NUM_LINES> LineTableType;
+	typedef std::array<BitboardType, NUM_COLS> ColumnTableType;
+
+	//The bitboards of every space in each column
+	static constexpr ColumnTableType COL_MASKS = [] {
+		ColumnTableType masks{};
+
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			masks[col] = ((static_cast<BitboardType>(1) << NUM_ROWS) - 1) << (col * COL_HEIGHT);
+		}
+
+		return masks;
+	}();
+
+	//The bitboard of the bottom space of every column
+	static constexpr BitboardType BOTTOM_MASK = [] {
+		BitboardType mask = 0;
+
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			mask |= static_cast<BitboardType>(1) << (col * COL_HEIGHT);
+		}
+
+		return mask;
+	}();
+
+	//The bitboard of every playable space on the board
+	static constexpr BitboardType BOARD_MASK = BOTTOM_MASK * ((static_cast<BitboardType>(1) << NUM_ROWS) - 1);
+
+	//The bitboard of every winning line on the board
+	static constexpr LineTableType WINNING_LINES = [] {
+		LineTableType lines{};
+		std::size_t numLines = 0;
+
+		//Height and column steps of the four directions: vertical, horizontal and both diagonals
+		const int heightSteps[4] = { 1, 0, 1, -1 };
+		const int colSteps[4] = { 0, 1, 1, 1 };
+
+		for (int direction = 0; direction < 4; direction++) {
+			for (int col = 0; col < NUM_COLS; col++) {
+				for (int height = 0; height < NUM_ROWS; height++) {
+					const int lastHeight = height + heightSteps[direction] * (CONNECT_N - 1);
+					const int lastCol = col + colSteps[direction] * (CONNECT_N - 1);
+
+					if (lastHeight < 0 || lastHeight >= NUM_ROWS || lastCol >= NUM_COLS) {
+						//The line would run off the board
+						continue;
+					}
+
+					BitboardType line = 0;
+					for (int x = 0; x < CONNECT_N; x++) {
+						line |= static_cast<BitboardType>(1) << ((col + colSteps[direction] * x) * COL_HEIGHT + height + heightSteps[direction] * x);
+					}
+
+					lines[numLines++] = line;
+				}
+			}
+		}
+
+		return lines;
+	}();
 
 	/*
 	Initializes the board as completely empty
@@ -23,9 +115,87 @@ public:
 
 	/*
 	Returns the board as a 2D array
-	@return std::array<std::array<std::int8_t, 7>, 6> The board
+	The array is rebuilt from the bitboards, so this should be kept out of hot loops where possible
+	@return std::array<std::array<std::int8_t, NUM_COLS>, NUM_ROWS> The board
+	*/
+	inline const BoardType getBoard() const {
+		BoardType result;
+
+		for (std::uint8_t row = 0; row < NUM_ROWS; row++) {
+			for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+				result[row][col] = getPieceUnchecked(row, col);
+			}
+		}
+
+		return result;
+	}
+
+	/*
+	Replaces the pieces on the board with the pieces in the given 2D array
+	Pieces in the array are expected to rest on top of each other in every column
+	@param boardArray The board in the format returned by getBoard
+	*/
+	inline void setBoard(const BoardType& boardArray) {
+		clearBoard();
+
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			for (std::uint8_t row = NUM_ROWS; row-- > 0;) {
+				if (boardArray[row][col] != NO_PIECE) {
+					addPiece(col, boardArray[row][col]);
+				}
+			}
+		}
+	}
+
+	/*
+	Returns a number that uniquely identifies the position on the board
+	Every column holds the red pieces below a single marker bit that sits on top of the column's pieces
+	The marker bits mean the key is never 0 and fits within COL_HEIGHT * NUM_COLS bits
+	@return KeyType The key of the position
+	*/
+	inline const KeyType getKey() const { return pieceMasks[RED_PIECE] + getOccupiedMask() + BOTTOM_MASK; }
+
+	/*
+	Replaces the pieces on the board with the position identified by the given key
+	@param key A key returned by getKey
+	*/
+	inline void setFromKey(const KeyType& key) {
+		clearBoard();
+
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			const BitboardType column = (key >> (col * COL_HEIGHT)) & (COL_MASKS[0] | squareBit(NUM_ROWS, 0));
+
+			//The highest bit in the column is the marker that sits on top of its pieces
+			std::uint8_t height = NUM_ROWS;
+			while (height > 0 && !(column & squareBit(height, 0))) {
+				height--;
+			}
+
+			const BitboardType pieces = (squareBit(height, 0) - 1) << (col * COL_HEIGHT);
+			const BitboardType red = (column << (col * COL_HEIGHT)) & pieces;
+
+			pieceMasks[RED_PIECE] |= red;
+			pieceMasks[YELLOW_PIECE] |= pieces & ~red;
+			heights[col] = height;
+			numPieces += height;
+		}
+	}
+
+	/*
+	Returns the columns that can still be played in the position identified by the given key
+	A column is full when its marker bit sits in the sentinel space above the top row
+	@param key A key returned by getKey
+	@return std::uint8_t A mask with bit n set if column n can be played
 	*/
-	inline const Board::BoardType getBoard() const { return board; }
+	static inline constexpr std::uint8_t legalMovesOfKey(const KeyType& key) {
+		std::uint8_t legalMoves = 0;
+
+		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
+			legalMoves |= static_cast<std::uint8_t>(!(key & squareBit(NUM_ROWS, col))) << col;
+		}
+
+		return legalMoves;
+	}
 
 	/*
 	Gets the piece at the given position
@@ -35,7 +205,7 @@ public:
 	*/
 	inline const std::int8_t getPiece(const std::uint8_t& row, const std::uint8_t& col) const {
 		if (positionInBounds(row, col)) {
-			return board.at(row).at(col);
+			return getPieceUnchecked(row, col);
 		}
 
 		//If the position is out of bounds, it may as well just be no piece
@@ -49,29 +219,27 @@ public:
 	@param type The type of piece to add (either RED_PIECE or YELLOW_PIECE)
 	@return bool true if successful or false otherwise
 	*/
-	inline const bool addPiece(const std::uint8_t& col, const int& type) {
-		//Make sure the column is in bounds
-		if (!colInBounds(col)) {
-			return false;
-		}
+	inline const bool addPiece(const std::uint8_t& col, const int& type) { return dropPiece(col, type) != INVALID_SQUARE; }
 
-		//Check if the topmost space in the column is filled
-		if (colIsFull(col)) {
-			//No space to add the piece
-			return false;
-		}
-
-		//Loop through the column to find the spot where the piece can be added
-		for (std::uint8_t row = 1; row < board.size(); row++) {
-			if (getPiece(row, col) != NO_PIECE) {
-				board.at(row - 1).at(col) = type;
-				return true;
-			}
+	/*
+	Adds a piece to the board in the given column if possible and returns the square it landed on
+	The square can be passed to checkForWinAt to skip finding the landing row again
+	@param col The column in which to add the piece
+	@param type The type of piece to add (either RED_PIECE or YELLOW_PIECE)
+	@return std::uint8_t The bit index of the square the piece landed on or INVALID_SQUARE if the move was not possible
+	*/
+	inline const std::uint8_t dropPiece(const std::uint8_t& col, const int& type) {
+		//Make sure the column is in bounds and has space for the piece
+		if (!validMove(col)) {
+			return INVALID_SQUARE;
 		}
 
-		//The very last row is the space that is open
-		board.at(board.size() - 1).at(col) = type;
-		return true;
+		//The column height is the index of the lowest open space in the column
+		const std::uint8_t square = col * COL_HEIGHT + heights[col];
+		pieceMasks[type] |= static_cast<BitboardType>(1) << square;
+		heights[col]++;
+		numPieces++;
+		return square;
 	}
 
 	/*
@@ -108,162 +276,234 @@ public:
 	void printBoard() const;
 
 	/*
-	Returns true if there are four pieces in a row on the board or false otherwise
+	Returns true if the player who owns the top piece of the given column has CONNECT_N pieces in a row
 	@param col The column where the last piece was placed
+	@return bool true if that player has won or false otherwise
 	*/
 	inline const bool checkForWin(const std::uint8_t& col) const {
-		unsigned int piecesInARow = 1;
-		int type;
-		std::uint8_t row = UINT8_MAX;
-
-		//Find the row in which the last piece was placed
-		for (std::uint8_t r = 0; r < board.size(); r++) {
-			if (getPiece(r, col) != NO_PIECE) {
-				type = getPiece(r, col);
-				row = r;
-				break;
-			}
-		}
-
-		if (row == UINT8_MAX) {
-			//The column must be out of bounds
+		if (!colInBounds(col) || heights[col] == 0) {
+			//There is no piece in this column
 			return false;
 		}
 
-		//Check for pieces below the current
-		if (row <= 2) { //The current row must be at least up to 2 for there to be 4 in a vertical row
-			for (std::uint8_t r = row + 1; r < board.size(); r++) {
-				if (getPiece(r, col) == type) {
-					piecesInARow++;
-				}
-				else {
-					break;
-				}
-			}
-		}
+		return checkForWinAt(col * COL_HEIGHT + heights[col] - 1);
+	}
 
-		if (piecesInARow >= 4) {
-			return true;
-		}
+	/*
+	Returns true if the player who owns the piece on the given square has CONNECT_N pieces in a row
+	@param square The square returned by dropPiece (must be occupied)
+	@return bool true if that player has won or false otherwise
+	*/
+	inline const bool checkForWinAt(const std::uint8_t& square) const {
+		//A square that is not yellow must be red, so this picks the owner's bitboard without branching
+		const int type = static_cast<int>((pieceMasks[YELLOW_PIECE] >> square) & 1);
 
-		//Reset the piece counter
-		piecesInARow = 1;
+		return isWinningMask(pieceMasks[type]);
+	}
 
-		//Check for pieces to the left and right of the current
-		//Start with the left
-		if (col > 0) {
-			for (std::uint8_t c = col - 1; c < UINT8_MAX; c--) {
-				if (getPiece(row, c) == type) {
-					piecesInARow++;
-				}
-				else {
-					break;
-				}
-			}
-		}
+	/*
+	Returns true if the given bitboard contains CONNECT_N pieces in a row in any direction
+	Each direction is a fixed shift: the sentinel bit on top of every column keeps lines from wrapping between columns
+	@param mask The bitboard of one player's pieces
+	@return bool true if the bitboard contains a winning line or false otherwise
+	*/
+	static inline constexpr bool isWinningMask(const BitboardType& mask) {
+		return (runsOf(mask, 1) | runsOf(mask, COL_HEIGHT) | runsOf(mask, COL_HEIGHT + 1) | runsOf(mask, COL_HEIGHT - 1)) != 0;
+	}
 
-		//Now check the right
-		for (std::uint8_t c = col + 1; c < board.at(0).size(); c++) {
-			if (getPiece(row, c) == type) {
-				piecesInARow++;
-			}
-			else {
-				break;
-			}
-		}
+	/*
+	Returns every empty space that would complete CONNECT_N in a row for the given pieces, whether or not a piece can be dropped there yet
+	Uses the same shifts as isWinningMask, so a threat never wraps between columns
+	@param mask The bitboard of one player's pieces
+	@param occupied The bitboard of every piece on the board
+	@return BitboardType The bitboard of the winning spaces
+	*/
+	static inline constexpr BitboardType winningSpaces(const BitboardType& mask, const BitboardType& occupied) {
+		return (gapsOf(mask, 1) | gapsOf(mask, COL_HEIGHT) | gapsOf(mask, COL_HEIGHT + 1) | gapsOf(mask, COL_HEIGHT - 1)) & BOARD_MASK & ~occupied;
+	}
 
-		if (piecesInARow >= 4) {
-			return true;
-		}
+	/*
+	Returns the space that the next piece in every column that is not full would land on
+	@return BitboardType The bitboard with one bit set for every legal move
+	*/
+	inline const BitboardType getPlayableMask() const { return (getOccupiedMask() + BOTTOM_MASK) & BOARD_MASK; }
 
-		//Reset the piece counter
-		piecesInARow = 1;
+	/*
+	Returns true if the board is completely filled or false otherwise
+	@return bool true if the board is completely full or false otherwise
+	*/
+	inline const bool isFull() const { return numPieces == NUM_ROWS * NUM_COLS; }
 
-		//Check the diagonals starting with up and to the left and down and to the right (\)
-		//Start with up and to the left
-		int offset = 1;
-		while (getPiece(row - offset, col - offset) == type) {
-			piecesInARow++;
-			offset++;
+	/*
+	Returns true if the given column is full or false otherwise
+	@param col The column to check
+	@return bool true if the given column is full or false otherwise
+	*/
+	inline const bool colIsFull(const std::uint8_t& col) const {
+		//Make sure the column is in bounds
+		if (colInBounds(col)) {
+			return heights[col] == NUM_ROWS;
 		}
 
-		//Now do down and to the right
-		offset = 1;
-		while (getPiece(row + offset, col + offset) == type) {
-			piecesInARow++;
-			offset++;
-		}
+		//The column may as well be considered full since it does not exist
+		return true;
+	}
 
-		if (piecesInARow >= 4) {
-			return true;
-		}
+	/*
+	Returns the number of pieces in the given column
+	@param col The column to check (must be in bounds)
+	@return std::uint8_t The number of pieces in the column
+	*/
+	inline const std::uint8_t getColHeight(const std::uint8_t& col) const { return heights[col]; }
 
-		//Reset the piece counter
-		piecesInARow = 1;
+	/*
+	Returns the total number of pieces on the board
+	@return std::uint8_t The number of pieces on the board
+	*/
+	inline const std::uint8_t getNumPieces() const { return numPieces; }
 
-		//Check the diagonal going from up and to the right to down and to the left (/)
-		//Start with going up and to the right
-		offset = 1;
-		while (getPiece(row - offset, col + offset) == type) {
-			piecesInARow++;
-			offset++;
-		}
+	/*
+	Returns the bitboard of all of the pieces of the given type
+	@param type The type of piece (either RED_PIECE or YELLOW_PIECE)
+	@return BitboardType The bitboard with one bit set for every piece of that type
+	*/
+	inline const BitboardType getPieceMask(const int& type) const { return pieceMasks[type]; }
 
-		//Now go down and to the left
-		offset = 1;
-		while (getPiece(row + offset, col - offset) == type) {
-			piecesInARow++;
-			offset++;
-		}
+	/*
+	Returns the bitboard of every occupied space on the board
+	@return BitboardType The bitboard with one bit set for every piece on the board
+	*/
+	inline const BitboardType getOccupiedMask() const { return pieceMasks[RED_PIECE] | pieceMasks[YELLOW_PIECE]; }
 
-		if (piecesInARow >= 4) {
-			return true;
-		}
+	/*
+	Replaces all of the pieces on the board with NO_PIECE
+	*/
+	inline void clearBoard() {
+		pieceMasks[RED_PIECE] = 0;
+		pieceMasks[YELLOW_PIECE] = 0;
+		heights.fill(0);
+		numPieces = 0;
+	}
 
-		//No matches of four were found
-		return false;
+private:
+	//One bitboard per piece type, indexed by RED_PIECE and YELLOW_PIECE
+	std::array<BitboardType, 2> pieceMasks;
+
+	//The number of pieces in each column, which is also the index of the next open space from the bottom
+	std::array<std::uint8_t, NUM_COLS> heights;
+
+	std::uint8_t numPieces;
+
+	/*
+	Returns the bit for the space at the given height (counted from the bottom) within the given column
+	@param height The height of the space from the bottom of the column
+	@param col The column of the space
+	@return BitboardType The bitboard with only that space set
+	*/
+	static inline constexpr BitboardType squareBit(const std::uint8_t& height, const std::uint8_t& col) {
+		return static_cast<BitboardType>(1) << (col * COL_HEIGHT + height);
 	}
 
 	/*
-	Returns true if the board is completely filled or false otherwise
-	@return bool true if the board is completely full or false otherwise
+	Checks that isWinningMask finds every line in WINNING_LINES and nothing on a board with every other column filled, and that winningSpaces finds the gap in every line missing one piece
+	This is evaluated at compile time by the constructor
+	@return bool true if the shift kernel agrees with the line table
 	*/
-	inline const bool isFull() const {
-		for (std::uint8_t col = 0; col < NUM_COLS; col++) {
-			if (!colIsFull(col)) {
+	static constexpr bool winningKernelMatchesLines() {
+		for (std::size_t x = 0; x < NUM_LINES; x++) {
+			if (!isWinningMask(WINNING_LINES[x])) {
 				return false;
 			}
 		}
 
+		//No line can be made from columns that are not next to each other if lines must be longer than a column
+		BitboardType alternatingColumns = 0;
+		for (std::uint8_t col = 0; col < NUM_COLS; col += 2) {
+			alternatingColumns |= COL_MASKS[col];
+		}
+
+		if (NUM_ROWS < CONNECT_N && isWinningMask(alternatingColumns)) {
+			return false;
+		}
+
+		//Every line with one piece missing must be a threat on the missing space
+		for (std::size_t x = 0; x < NUM_LINES; x++) {
+			for (std::uint8_t square = 0; square < COL_HEIGHT * NUM_COLS; square++) {
+				const BitboardType bit = static_cast<BitboardType>(1) << square;
+
+				if ((WINNING_LINES[x] & bit) && !(winningSpaces(WINNING_LINES[x] ^ bit, WINNING_LINES[x] ^ bit) & bit)) {
+					return false;
+				}
+			}
+		}
+
 		return true;
 	}
 
 	/*
-	Returns true if the given column is full or false otherwise
-	@param col The column to check
-	@return bool true if the given column is full or false otherwise
+	Returns a bitboard with a bit set on every square that starts a run of CONNECT_N pieces in the given direction
+	@param mask The bitboard of one player's pieces
+	@param shift The distance between neighbouring squares in the direction being checked
+	@return BitboardType The starting squares of every run
 	*/
-	inline const bool colIsFull(const std::uint8_t& col) const {
-		//Make sure the column is in bounds
-		if (colInBounds(col)) {
-			return getPiece(0, col) != NO_PIECE;
+	static inline constexpr BitboardType runsOf(const BitboardType& mask, const std::uint8_t& shift) {
+		BitboardType runs = mask;
+
+		for (std::uint8_t x = 1; x < CONNECT_N; x++) {
+			runs &= mask >> (x * shift);
 		}
 
-		//The column may as well be considered full since it does not exist
-		return true;
+		return runs;
 	}
 
 	/*
-	Replaces all of the pieces on the board with NO_PIECE
+	Returns a bitboard with a bit set on every square that is the only one missing from a run of CONNECT_N pieces in the given direction
+	@param mask The bitboard of one player's pieces
+	@param shift The distance between neighbouring squares in the direction being checked
+	@return BitboardType The missing squares, which include sentinel and occupied squares that the caller must mask off
 	*/
-	inline void clearBoard() {
-		for (std::uint8_t row = 0; row < NUM_ROWS; row++) {
-			for (std::uint8_t col = 0; col < NUM_COLS; col++) {
-				board.at(row).at(col) = NO_PIECE;
+	static inline constexpr BitboardType gapsOf(const BitboardType& mask, const std::uint8_t& shift) {
+		BitboardType gaps = 0;
+
+		//Squares with gap pieces in a row just before them, which grows by one piece for each position of the gap along the run
+		BitboardType before = ~static_cast<BitboardType>(0);
+
+		for (std::uint8_t gap = 0; gap < CONNECT_N; gap++) {
+			//The rest of the run must follow the gap
+			BitboardType after = before;
+			for (std::uint8_t x = 1; x < CONNECT_N - gap; x++) {
+				after &= mask >> (x * shift);
 			}
+
+			gaps |= after;
+			before &= mask << ((gap + 1) * shift);
 		}
+
+		return gaps;
 	}
 
-private:
-	BoardType board;
-};
\ No newline at end of file
+	/*
+	Gets the piece at the given position without checking bounds
+	@param row The row to get the piece from (row 0 is the top of the board)
+	@param col The column to get the piece from
+	@return std::int8_t One of the constants corresponding to a piece
+	*/
+	inline const std::int8_t getPieceUnchecked(const std::uint8_t& row, const std::uint8_t& col) const {
+		const BitboardType bit = squareBit(NUM_ROWS - 1 - row, col);
+
+		if (pieceMasks[RED_PIECE] & bit) {
+			return RED_PIECE;
+		}
+
+		if (pieceMasks[YELLOW_PIECE] & bit) {
+			return YELLOW_PIECE;
+		}
+
+		return NO_PIECE;
+	}
+};
+
+//The board sizes that the program can be run with (named rows x columns)
+typedef Board<4, 5, 4> Board4x5;
+typedef Board<5, 6, 4> Board5x6;
+typedef Board<6, 7, 4> Board6x7;
@@ -0,0 +1,64 @@
+#include "BoardBatch.h"
+#include <cstring>
+
+template <class BoardT>
+BoardBatch<BoardT>::BoardBatch(const std::size_t& numGames)
+	: movers((numGames + LANES - 1) / LANES * LANES, 0), occupied(movers.size(), 0), numPieces(movers.size(), 0)
+{}
+
+template <class BoardT>
+void BoardBatch<BoardT>::dropPieces(const std::uint8_t* columns, Outcome* outcomes)
+{
+#ifdef __AVX2__
+	const __m256i bottom = _mm256_set1_epi64x(BoardT::BOTTOM_MASK);
+	const __m256i firstColumn = _mm256_set1_epi64x(BoardT::COL_MASKS[0]);
+	const __m256i fullBoard = _mm256_set1_epi64x(BoardT::BOARD_MASK);
+	const __m256i colHeight = _mm256_set1_epi64x(BoardT::COL_HEIGHT);
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (std::size_t game = 0; game < size(); game += LANES) {
+		__m256i* moverLanes = reinterpret_cast<__m256i*>(&movers[game]);
+		__m256i* occupiedLanes = reinterpret_cast<__m256i*>(&occupied[game]);
+
+		//Widen the four columns to one per lane and turn each into the mask of its column
+		std::uint32_t packedColumns;
+		std::memcpy(&packedColumns, &columns[game], sizeof(packedColumns));
+		const __m256i cols = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(static_cast<int>(packedColumns)));
+		const __m256i colMasks = _mm256_sllv_epi64(firstColumn, _mm256_mul_epu32(cols, colHeight));
+
+		//Adding a piece to the bottom of every column carries into the lowest empty space of each, which is where the piece lands
+		const __m256i before = _mm256_loadu_si256(occupiedLanes);
+		const __m256i piece = _mm256_and_si256(_mm256_add_epi64(before, bottom), colMasks);
+		const __m256i pieces = _mm256_or_si256(_mm256_loadu_si256(moverLanes), piece);
+		const __m256i after = _mm256_or_si256(before, piece);
+
+		//Bit n is set if game n has no run, or if its board is full
+		const int noWins = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(winningRuns(pieces), zero)));
+		const int fulls = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(after, fullBoard)));
+
+		//The other player moves next, and their pieces are every piece that is not the mover's
+		_mm256_storeu_si256(moverLanes, _mm256_xor_si256(after, pieces));
+		_mm256_storeu_si256(occupiedLanes, after);
+
+		for (std::size_t lane = 0; lane < LANES; lane++) {
+			numPieces[game + lane]++;
+			outcomes[game + lane] = !((noWins >> lane) & 1) ? Outcome::WIN : ((fulls >> lane) & 1 ? Outcome::DRAW : Outcome::ONGOING);
+		}
+	}
+#else
+	for (std::size_t game = 0; game < size(); game++) {
+		const BitboardType piece = (occupied[game] + BoardT::BOTTOM_MASK) & BoardT::COL_MASKS[columns[game]];
+		const BitboardType pieces = movers[game] | piece;
+
+		occupied[game] |= piece;
+		movers[game] = occupied[game] ^ pieces;
+		numPieces[game]++;
+
+		outcomes[game] = BoardT::isWinningMask(pieces) ? Outcome::WIN : (occupied[game] == BoardT::BOARD_MASK ? Outcome::DRAW : Outcome::ONGOING);
+	}
+#endif
+}
+
+template class BoardBatch<Board4x5>;
+template class BoardBatch<Board5x6>;
+template class BoardBatch<Board6x7>;
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Board.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+/*
+Many games on boards of the same size, stored as a structure of arrays so that a move can be made in every game at once
+Each game keeps the pieces of the player to move and every occupied space, which is all that dropping a piece and checking for a win need
+Built with AVX2, drops, win checks and full board checks are made on four games per instruction, and otherwise on one game at a time
+@param BoardT The type of board the games are played on
+*/
+template <class BoardT>
+class BoardBatch
+{
+public:
+	typedef typename BoardT::BitboardType BitboardType;
+	typedef typename BoardT::KeyType KeyType;
+
+	enum class Outcome : std::uint8_t { ONGOING, WIN, DRAW };
+
+	//The number of games a vector instruction works on, which the number of games is rounded up to
+	static constexpr std::size_t LANES = 4;
+
+	/*
+	Creates the given number of empty boards
+	@param numGames The number of games to play at once, which is rounded up to a multiple of LANES
+	*/
+	BoardBatch(const std::size_t& numGames);
+
+	inline const std::size_t size() const { return movers.size(); }
+
+	/*
+	Empties the board of one game so a new game can be played on it
+	@param game The index of the game
+	*/
+	inline void clearBoard(const std::size_t& game) {
+		movers[game] = 0;
+		occupied[game] = 0;
+		numPieces[game] = 0;
+	}
+
+	/*
+	Returns the piece of the player to move in one game, where YELLOW_PIECE always moves first
+	@param game The index of the game
+	@return int Either YELLOW_PIECE or RED_PIECE
+	*/
+	inline const int getTurn(const std::size_t& game) const { return numPieces[game] & 1 ? BoardT::RED_PIECE : BoardT::YELLOW_PIECE; }
+
+	/*
+	Returns the bitboard of the pieces of the player to move in one game
+	@param game The index of the game
+	@return BitboardType The bitboard with one bit set for every piece of that player
+	*/
+	inline const BitboardType getMoverMask(const std::size_t& game) const { return movers[game]; }
+
+	/*
+	Returns the bitboard of every occupied space in one game
+	@param game The index of the game
+	@return BitboardType The bitboard with one bit set for every piece on the board
+	*/
+	inline const BitboardType getOccupiedMask(const std::size_t& game) const { return occupied[game]; }
+
+	inline const std::uint8_t getNumPieces(const std::size_t& game) const { return numPieces[game]; }
+
+	/*
+	Returns the key of the position in one game, which is the same as the key a Board with the same pieces returns
+	@param game The index of the game
+	@return KeyType The key of the position
+	*/
+	inline const KeyType getKey(const std::size_t& game) const {
+		const BitboardType red = getTurn(game) == BoardT::RED_PIECE ? movers[game] : occupied[game] ^ movers[game];
+
+		return red + occupied[game] + BoardT::BOTTOM_MASK;
+	}
+
+	/*
+	Drops a piece for the player to move in every game, then hands the turn to the other player
+	Games that have already ended are played on as well, so they must be cleared before their outcomes mean anything again
+	@param columns The column to play in each game, which must be in bounds and should not be full
+	@param outcomes Set to WIN for each game the move won, DRAW for each game whose board is now full and ONGOING for the rest
+	*/
+	void dropPieces(const std::uint8_t* columns, Outcome* outcomes);
+
+private:
+	std::vector<BitboardType> movers;
+	std::vector<BitboardType> occupied;
+	std::vector<std::uint8_t> numPieces;
+
+#ifdef __AVX2__
+	/*
+	Finds the squares that start a run of CONNECT_N pieces in four games at once (see Board::isWinningMask)
+	@param pieces The bitboards of one player's pieces in each game
+	@return __m256i The starting squares of every run, which is 0 for each game without one
+	*/
+	static inline __m256i winningRuns(const __m256i& pieces) {
+		const int shifts[4] = { 1, BoardT::COL_HEIGHT, BoardT::COL_HEIGHT + 1, BoardT::COL_HEIGHT - 1 };
+		__m256i runs = _mm256_setzero_si256();
+
+		for (const int shift : shifts) {
+			__m256i direction = pieces;
+
+			for (int x = 1; x < BoardT::CONNECT_N; x++) {
+				direction = _mm256_and_si256(direction, _mm256_srl_epi64(pieces, _mm_cvtsi32_si128(x * shift)));
+			}
+
+			runs = _mm256_or_si256(runs, direction);
+		}
+
+		return runs;
+	}
+#endif
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/*
+Stores an integer in the given bytes, least significant byte first, so files are the same on every machine
+@param bytes Where to store the integer
+@param value The integer
+@param size The number of bytes to store
+*/
+inline void storeLittleEndian(char* bytes, std::uint64_t value, const std::size_t& size) {
+	for (std::size_t x = 0; x < size; x++) {
+		bytes[x] = static_cast<char>(value & 0xFF);
+		value >>= 8;
+	}
+}
+
+/*
+Loads an integer stored by storeLittleEndian
+@param bytes Where the integer is stored
+@param size The number of bytes to load
+@return std::uint64_t The integer
+*/
+inline std::uint64_t loadLittleEndian(const char* bytes, const std::size_t& size) {
+	std::uint64_t value = 0;
+
+	for (std::size_t x = size; x-- > 0;) {
+		value = (value << 8) | static_cast<std::uint8_t>(bytes[x]);
+	}
+
+	return value;
+}
+
+/*
+Appends an integer using 7 bits per byte, with the top bit of each byte set if more bytes follow, so small integers take a single byte
+@param bytes The buffer to append to
+@param value The integer
+*/
+inline void appendVarint(std::vector<char>& bytes, std::uint64_t value) {
+	while (value >= 0x80) {
+		bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+
+	bytes.push_back(static_cast<char>(value));
+}
+
+/*
+Loads an integer stored by appendVarint
+@param position The first byte of the integer, which is moved past the integer
+@param end The end of the buffer
+@param value Set to the integer
+@return bool true if a whole integer was loaded or false if the buffer ended first or the integer is too long
+*/
+inline bool loadVarint(const char*& position, const char* end, std::uint64_t& value) {
+	value = 0;
+
+	for (unsigned int shift = 0; shift < 64 && position != end; shift += 7) {
+		const std::uint8_t byte = static_cast<std::uint8_t>(*position++);
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,130 @@
+#include "Checkpointer.h"
+#include <algorithm>
+#include <chrono>
+
+template <class BoardT>
+Checkpointer<BoardT>::Checkpointer()
+	: jobReady(false), busy(false), journal(false), stopping(false)
+{
+	//Started last so the thread never sees members that are not yet initialized
+	writer = std::thread(&Checkpointer::runWriter, this);
+}
+
+template <class BoardT>
+Checkpointer<BoardT>::~Checkpointer()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wake.notify_one();
+	writer.join();
+}
+
+template <class BoardT>
+void Checkpointer<BoardT>::add(const AI<BoardT>& ai, FileManager<BoardT>& file)
+{
+	std::unique_ptr<Target> target(new Target());
+	target->ai = &ai;
+	target->file = &file;
+
+	targets.push_back(std::move(target));
+}
+
+template <class BoardT>
+bool Checkpointer<BoardT>::checkpoint(const bool& journal)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+
+		if (busy) {
+			//Waiting would stall training for as long as the writer takes, so leave the changes for the next checkpoint
+			stats.skipped++;
+			return false;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->journal = journal;
+		jobReady = true;
+		busy = true;
+		stats.checkpoints++;
+	}
+
+	wake.notify_one();
+	return true;
+}
+
+template <class BoardT>
+void Checkpointer<BoardT>::wait()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	finished.wait(lock, [this]() { return !busy; });
+}
+
+template <class BoardT>
+typename Checkpointer<BoardT>::Stats Checkpointer<BoardT>::getStats() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stats;
+}
+
+template <class BoardT>
+void Checkpointer<BoardT>::runWriter()
+{
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this]() { return jobReady || stopping; });
+
+			//A checkpoint handed over just before stopping is still written
+			if (!jobReady) {
+				return;
+			}
+
+			jobReady = false;
+		}
+
+		const auto start = std::chrono::steady_clock::now();
+		std::uint64_t bytesWritten = 0;
+		typename AI<BoardT>::DataType::LockTimes lockTimes;
+		bool succeeded = true;
+
+		for (auto& target : targets) {
+			//A file that has no data file yet, a journal that is too large or a save that failed is written in full instead
+			const bool written = journal ? target->file->appendChanges(*target->ai) : target->file->writeAIData(*target->ai);
+
+			if (written) {
+				bytesWritten += target->file->getLastBytesWritten();
+			}
+			else {
+				succeeded = false;
+			}
+
+			lockTimes.add(target->file->takeLockTimes());
+		}
+
+		const double writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busy = false;
+			stats.lastWriteSeconds = writeSeconds;
+			stats.totalWriteSeconds += writeSeconds;
+			stats.lastBytesWritten = bytesWritten;
+			stats.totalBytesWritten += bytesWritten;
+			stats.lastStallSeconds = lockTimes.totalSeconds;
+			stats.totalStallSeconds += lockTimes.totalSeconds;
+			stats.longestStallSeconds = std::max(stats.longestStallSeconds, lockTimes.longestSeconds);
+			stats.lastSucceeded = succeeded;
+		}
+
+		finished.notify_all();
+	}
+}
+
+template class Checkpointer<Board4x5>;
+template class Checkpointer<Board5x6>;
+template class Checkpointer<Board6x7>;
@@ -0,0 +1,126 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "AI.h"
+#include "FileManager.h"
+
+/*
+Saves the data of AI objects on a background thread so that training can carry on while the files are written
+The writer saves straight from the tables, copying one shard at a time, so memory never holds a second copy of a whole table
+and a training thread only waits if it needs the one shard being copied (see Stats::lastStallSeconds)
+A full checkpoint is therefore not the table as it was at one moment, since each shard is captured a little later than the one before
+That is safe to give up because no board depends on another: each shard is captured together with its changes, so the journal after it still replays exactly,
+and a file mixing moments is only what training would have learned had some games finished a little earlier or later
+@param BoardT The type of board the AI objects play on
+*/
+template <class BoardT>
+class Checkpointer
+{
+public:
+	/*
+	The cost of the checkpoints taken so far
+	*/
+	struct Stats
+	{
+		std::uint64_t checkpoints = 0;
+
+		//Checkpoints that were not taken because the writer was still busy with the one before
+		std::uint64_t skipped = 0;
+
+		//The time the writer thread took to write the files
+		double lastWriteSeconds = 0;
+		double totalWriteSeconds = 0;
+
+		//The time the writer kept shards locked while copying them or taking their changes, which training threads needing those shards had to wait for
+		double lastStallSeconds = 0;
+		double totalStallSeconds = 0;
+
+		//The longest the writer kept any one shard locked, which is the longest a training thread could have waited at once
+		double longestStallSeconds = 0;
+
+		std::uint64_t lastBytesWritten = 0;
+		std::uint64_t totalBytesWritten = 0;
+
+		//false if any file of the last finished checkpoint could not be written
+		bool lastSucceeded = true;
+	};
+
+	/*
+	Starts the writer thread
+	*/
+	Checkpointer();
+
+	/*
+	Finishes the checkpoint being written and stops the writer thread
+	*/
+	~Checkpointer();
+
+	Checkpointer(const Checkpointer&) = delete;
+	Checkpointer& operator=(const Checkpointer&) = delete;
+
+	/*
+	Adds an AI whose data will be saved by every checkpoint
+	Must not be called while a checkpoint is being written
+	@param ai The AI to save
+	@param file The file to save it to, which must not be used by anything else until the checkpoint is written (see wait)
+	*/
+	void add(const AI<BoardT>& ai, FileManager<BoardT>& file);
+
+	/*
+	Hands the data of every AI to the writer thread, which saves it while the AI objects keep learning
+	The tables must be concurrent (see Trainer::start), or left alone, until wait returns
+	@param journal true to only save the changes since the last checkpoint, which needs the tables to be tracking changes
+	@return bool true if the checkpoint was started or false if the writer was still busy, in which case the next checkpoint also saves what this one would have
+	*/
+	bool checkpoint(const bool& journal);
+
+	/*
+	Waits until the writer thread has finished the checkpoint being written
+	*/
+	void wait();
+
+	/*
+	Returns the cost of the checkpoints taken so far
+	@return Stats The cost of the checkpoints
+	*/
+	Stats getStats() const;
+
+private:
+	/*
+	An AI and the file it is saved to
+	*/
+	struct Target
+	{
+		const AI<BoardT>* ai;
+		FileManager<BoardT>* file;
+	};
+
+	std::vector<std::unique_ptr<Target>> targets;
+
+	mutable std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+
+	//A checkpoint has been started and the writer has not picked it up yet
+	bool jobReady;
+
+	//A checkpoint has been started and the writer has not finished it yet
+	bool busy;
+
+	//true if the checkpoint being written only saves the changes (see FileManager::appendChanges)
+	bool journal;
+
+	bool stopping;
+	Stats stats;
+
+	std::thread writer;
+
+	/*
+	Writes every checkpoint handed to the writer thread until the Checkpointer is destroyed
+	*/
+	void runWriter();
+};
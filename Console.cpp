@@ -0,0 +1,73 @@
+#include "Console.h"
+
+#ifdef _WIN32
+#include <conio.h>
+
+bool Console::keyPressed()
+{
+	return _kbhit() != 0;
+}
+
+int Console::readKey()
+{
+	return _getche();
+}
+#else
+#include <cstdio>
+#include <sys/select.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace
+{
+	/*
+	Turns off line buffering on the terminal for as long as it exists, so single key presses can be seen
+	*/
+	class RawTerminal
+	{
+	public:
+		RawTerminal() : changed(tcgetattr(STDIN_FILENO, &original) == 0) {
+			if (changed) {
+				termios raw = original;
+				raw.c_lflag &= ~ICANON;
+				tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+			}
+		}
+
+		~RawTerminal() {
+			if (changed) {
+				tcsetattr(STDIN_FILENO, TCSANOW, &original);
+			}
+		}
+
+	private:
+		termios original;
+		bool changed;
+	};
+}
+
+bool Console::keyPressed()
+{
+	RawTerminal terminal;
+
+	fd_set input;
+	FD_ZERO(&input);
+	FD_SET(STDIN_FILENO, &input);
+
+	//Poll without waiting
+	timeval timeout = { 0, 0 };
+	return select(STDIN_FILENO + 1, &input, nullptr, nullptr, &timeout) > 0;
+}
+
+int Console::readKey()
+{
+	RawTerminal terminal;
+
+	unsigned char key = 0;
+	if (read(STDIN_FILENO, &key, 1) != 1) {
+		return EOF;
+	}
+
+	return key;
+}
+#endif
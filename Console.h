@@ -0,0 +1,20 @@
+#pragma once
+
+/*
+Reads single key presses from the console without waiting for the enter key, on both Windows and POSIX systems
+*/
+class Console
+{
+public:
+	/*
+	Returns true if a key has been pressed and is waiting to be read
+	@return bool true if a key is waiting or false otherwise
+	*/
+	static bool keyPressed();
+
+	/*
+	Reads one key press, waiting for one if none is waiting, and echoes it
+	@return int The key that was pressed
+	*/
+	static int readKey();
+};
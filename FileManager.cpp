@@ -1,32 +1,347 @@
 #include "FileManager.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "AtomicFile.h"
+#include "ByteOrder.h"
 
-FileManager::FileManager(const std::string& filename)
+template <class BoardT>
+constexpr std::array<char, 4> FileManager<BoardT>::MAGIC;
+
+template <class BoardT>
+constexpr std::array<char, 4> FileManager<BoardT>::JOURNAL_MAGIC;
+
+template <class BoardT>
+FileManager<BoardT>::FileManager(const std::string& filename)
+	: hasBase(false), baseChecksum(0), baseSize(0), journalSize(0), lastBytesWritten(0), lastBytesRead(0), lastReadSeconds(0)
 {
 	this->filename = filename;
 }
 
-void FileManager::readAIData(AI & ai)
+template <class BoardT>
+bool FileManager<BoardT>::readAIData(AI<BoardT>& ai)
 {
-	std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>> data;
-	char currentChar = -2;
-	
+	//Read straight into the AI's own table
+	typename AI<BoardT>::DataType& data = *ai.getSharedData();
+	data.clear();
+
+	const auto start = std::chrono::steady_clock::now();
+	lastBytesRead = 0;
+	lastReadSeconds = 0;
+
 	//Open the input file
 	std::ifstream input;
 	input.open(filename, std::ifstream::in | std::ifstream::binary);
 
 	//Make sure the file opened properly
 	if (!input.is_open()) {
-		std::cout << "\nERROR: Could not open file " << filename;
-		return;
+		std::error_code error;
+
+		if (!std::filesystem::exists(filename, error) && !error) {
+			//The AI has not learned anything yet
+			std::cout << "\nStarting without data, " << filename << " does not exist yet\n";
+			return true;
+		}
+
+		std::cout << "\nERROR: Could not open file " << filename << "\n";
+		return false;
+	}
+
+	std::array<char, HEADER_SIZE> header;
+	input.read(header.data(), HEADER_SIZE);
+
+	if (input.gcount() == static_cast<std::streamsize>(HEADER_SIZE) && std::equal(MAGIC.begin(), MAGIC.end(), header.begin())) {
+		const std::uint16_t version = static_cast<std::uint16_t>(loadLittleEndian(header.data() + 4, 2));
+		const std::uint8_t rows = static_cast<std::uint8_t>(header[8]);
+		const std::uint8_t cols = static_cast<std::uint8_t>(header[9]);
+		const std::uint8_t connectN = static_cast<std::uint8_t>(header[10]);
+
+		if (rows != BoardT::NUM_ROWS || cols != BoardT::NUM_COLS || connectN != BoardT::CONNECT_N) {
+			std::cout << "\nERROR: " << filename << " holds data for a " << static_cast<int>(rows) << "x" << static_cast<int>(cols) << " board\n";
+			return false;
+		}
+
+		bool valid = false;
+		if (version == VERSION) {
+			valid = readIndexedSections(input, header.data(), data);
+		}
+		else if (version == UNINDEXED_VERSION) {
+			valid = readSections(input, header.data(), data);
+		}
+		else if (version == FIXED_RECORD_VERSION) {
+			valid = readRecords(input, header.data(), data);
+		}
+		else {
+			std::cout << "\nERROR: " << filename << " is version " << version << " of the data format, which this program cannot read\n";
+		}
+
+		if (!valid) {
+			//Never use part of a damaged file
+			data.clear();
+			return false;
+		}
+
+		std::error_code error;
+		hasBase = true;
+		baseChecksum = loadLittleEndian(header.data() + 24, 8);
+		baseSize = std::filesystem::file_size(filename, error);
+
+		lastBytesRead = baseSize;
+		lastReadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		input.close();
+		replayJournal(data);
+		return true;
+	}
+
+	//Files without the magic are in the original format
+	input.clear();
+	input.seekg(0);
+	readLegacyData(input, data);
+	input.close();
+
+	std::error_code error;
+	lastBytesRead = std::filesystem::file_size(filename, error);
+
+	lastReadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "\nConverting " << filename << " to the current format...";
+	writeAIData(ai);
+	return true;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::readIndexedSections(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data)
+{
+	const std::uint64_t numRecords = loadLittleEndian(header + 16, 8);
+	const std::uint64_t expectedChecksum = loadLittleEndian(header + 24, 8);
+
+	std::error_code error;
+	const std::uint64_t fileSize = std::filesystem::file_size(filename, error);
+
+	//The trailer gives the position of the index, which lists every section
+	std::array<char, TRAILER_SIZE> trailer;
+	input.seekg(static_cast<std::streamoff>(fileSize - TRAILER_SIZE));
+	input.read(trailer.data(), TRAILER_SIZE);
+
+	const std::uint64_t indexStart = loadLittleEndian(trailer.data(), 8);
+	const std::uint64_t numSections = loadLittleEndian(trailer.data() + 8, 8);
+
+	if (error || fileSize < HEADER_SIZE + TRAILER_SIZE || input.gcount() != static_cast<std::streamsize>(TRAILER_SIZE)
+		|| indexStart < HEADER_SIZE || numSections > (fileSize - TRAILER_SIZE - indexStart) / INDEX_ENTRY_SIZE
+		|| indexStart + numSections * INDEX_ENTRY_SIZE + TRAILER_SIZE != fileSize) {
+		std::cout << "\nERROR: " << filename << " ends before all of its records\n";
+		return false;
+	}
+
+	std::vector<char> index(static_cast<std::size_t>(numSections * INDEX_ENTRY_SIZE));
+	input.seekg(static_cast<std::streamoff>(indexStart));
+	input.read(index.data(), index.size());
+
+	if (input.gcount() != static_cast<std::streamsize>(index.size()) || updateChecksum(0, index.data(), index.size()) != expectedChecksum) {
+		std::cout << "\nERROR: The checksum of " << filename << " does not match its records\n";
+		return false;
+	}
+
+	//Check the whole index before any thread trusts it
+	std::uint64_t indexedRecords = 0;
+	for (std::uint64_t x = 0; x < numSections; x++) {
+		const char* entry = index.data() + x * INDEX_ENTRY_SIZE;
+		const std::uint64_t sectionStart = loadLittleEndian(entry, 8);
+		const std::uint64_t sectionRecords = loadLittleEndian(entry + 8, 8);
+		const std::uint64_t sectionSize = loadLittleEndian(entry + 16, 8);
+
+		if (sectionStart < HEADER_SIZE || sectionStart > indexStart || sectionSize > indexStart - sectionStart || sectionRecords > numRecords - indexedRecords) {
+			std::cout << "\nERROR: " << filename << " holds an invalid record\n";
+			return false;
+		}
+
+		indexedRecords += sectionRecords;
+	}
+
+	if (indexedRecords != numRecords) {
+		std::cout << "\nERROR: " << filename << " ends before all of its records\n";
+		return false;
+	}
+
+	data.reserve(numRecords);
+
+	//Every section holds one shard of the table that was written, and shards are chosen the same way when reading,
+	//so threads working on different sections almost never wait for each other's locks
+	const bool wasConcurrent = data.isConcurrent();
+	data.setConcurrent(true);
+
+	std::atomic<std::uint64_t> nextSection(0);
+	std::atomic<bool> failed(false);
+
+	auto readSomeSections = [&]() {
+		//Each thread has its own stream, so reads at different positions never share a file position
+		std::ifstream sectionInput(filename, std::ifstream::in | std::ifstream::binary);
+		std::vector<char> section;
+
+		for (std::uint64_t x = nextSection++; x < numSections && !failed; x = nextSection++) {
+			const char* entry = index.data() + x * INDEX_ENTRY_SIZE;
+			const std::uint64_t sectionRecords = loadLittleEndian(entry + 8, 8);
+			const std::uint64_t sectionSize = loadLittleEndian(entry + 16, 8);
+
+			section.resize(static_cast<std::size_t>(sectionSize));
+			sectionInput.seekg(static_cast<std::streamoff>(loadLittleEndian(entry, 8)));
+			sectionInput.read(section.data(), section.size());
+
+			if (sectionInput.gcount() != static_cast<std::streamsize>(section.size()) || updateChecksum(0, section.data(), section.size()) != loadLittleEndian(entry + 24, 8)
+				|| !decodeSection(section.data(), section.size(), sectionRecords, data)) {
+				failed = true;
+			}
+		}
+	};
+
+	const std::size_t numThreads = static_cast<std::size_t>(std::min<std::uint64_t>(std::max(std::thread::hardware_concurrency(), 1u), std::max<std::uint64_t>(numSections, 1)));
+	std::vector<std::thread> threads;
+
+	for (std::size_t x = 1; x < numThreads; x++) {
+		threads.emplace_back(readSomeSections);
+	}
+
+	readSomeSections();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	data.setConcurrent(wasConcurrent);
+
+	if (failed) {
+		std::cout << "\nERROR: " << filename << " holds an invalid record\n";
+		return false;
 	}
 
+	return true;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::readSections(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data)
+{
+	const std::uint64_t numRecords = loadLittleEndian(header + 16, 8);
+	const std::uint64_t expectedChecksum = loadLittleEndian(header + 24, 8);
+
+	std::error_code error;
+	const std::uint64_t fileSize = std::filesystem::file_size(filename, error);
+
+	data.reserve(numRecords);
+
+	std::vector<char> section;
+	std::uint64_t checksum = 0;
+	std::uint64_t position = HEADER_SIZE;
+
+	for (std::uint64_t recordsLeft = numRecords; recordsLeft > 0;) {
+		section.resize(SECTION_HEADER_SIZE);
+		input.read(section.data(), SECTION_HEADER_SIZE);
+
+		const std::uint64_t sectionRecords = loadLittleEndian(section.data(), 8);
+		const std::uint64_t sectionSize = loadLittleEndian(section.data() + 8, 8);
+
+		if (input.gcount() != static_cast<std::streamsize>(SECTION_HEADER_SIZE) || error || sectionRecords > recordsLeft
+			|| sectionSize > fileSize - position - SECTION_HEADER_SIZE) {
+			std::cout << "\nERROR: " << filename << " ends before all of its records\n";
+			return false;
+		}
+
+		//Each section is read whole, which keeps the buffer to the size of one shard
+		section.resize(static_cast<std::size_t>(SECTION_HEADER_SIZE + sectionSize));
+		input.read(section.data() + SECTION_HEADER_SIZE, static_cast<std::streamsize>(sectionSize));
+
+		if (input.gcount() != static_cast<std::streamsize>(sectionSize)) {
+			std::cout << "\nERROR: " << filename << " ends before all of its records\n";
+			return false;
+		}
+
+		checksum = updateChecksum(checksum, section.data(), section.size());
+
+		if (!decodeSection(section.data() + SECTION_HEADER_SIZE, static_cast<std::size_t>(sectionSize), sectionRecords, data)) {
+			std::cout << "\nERROR: " << filename << " holds an invalid record\n";
+			return false;
+		}
+
+		position += section.size();
+		recordsLeft -= sectionRecords;
+	}
+
+	if (checksum != expectedChecksum) {
+		std::cout << "\nERROR: The checksum of " << filename << " does not match its records\n";
+		return false;
+	}
+
+	return true;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::readRecords(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data)
+{
+	const std::uint16_t recordSize = static_cast<std::uint16_t>(loadLittleEndian(header + 6, 2));
+	const std::uint64_t numRecords = loadLittleEndian(header + 16, 8);
+	const std::uint64_t expectedChecksum = loadLittleEndian(header + 24, 8);
+
+	if (recordSize != RECORD_SIZE) {
+		std::cout << "\nERROR: " << filename << " has records of an unknown size\n";
+		return false;
+	}
+
+	data.reserve(numRecords);
+
+	std::vector<char> block(RECORDS_PER_BLOCK * RECORD_SIZE);
+	std::uint64_t checksum = 0;
+
+	for (std::uint64_t recordsLeft = numRecords; recordsLeft > 0;) {
+		const std::size_t blockRecords = static_cast<std::size_t>(std::min<std::uint64_t>(recordsLeft, RECORDS_PER_BLOCK));
+		input.read(block.data(), blockRecords * RECORD_SIZE);
+
+		if (input.gcount() != static_cast<std::streamsize>(blockRecords * RECORD_SIZE)) {
+			std::cout << "\nERROR: " << filename << " ends before all of its records\n";
+			return false;
+		}
+
+		checksum = updateChecksum(checksum, block.data(), blockRecords * RECORD_SIZE);
+
+		for (std::size_t x = 0; x < blockRecords; x++) {
+			const char* record = block.data() + x * RECORD_SIZE;
+			const typename BoardT::KeyType key = loadLittleEndian(record, sizeof(typename BoardT::KeyType));
+
+			if (key != AI<BoardT>::DataType::TableType::EMPTY_KEY) {
+				data.emplace(key, decodePriorities(key, record));
+			}
+		}
+
+		recordsLeft -= blockRecords;
+	}
+
+	if (checksum != expectedChecksum) {
+		std::cout << "\nERROR: The checksum of " << filename << " does not match its records\n";
+		return false;
+	}
+
+	return true;
+}
+
+template <class BoardT>
+void FileManager<BoardT>::readLegacyData(std::ifstream& input, typename AI<BoardT>::DataType& data)
+{
+	char currentChar = -2;
+
+	//Used to convert the boards in the file into keys
+	BoardT keyBoard;
+
 	bool reading = true;
 	while (!input.eof()) {
 		//Read the board that is mapped to the priority data
-		Board::BoardType currentBoard;
+		typename BoardT::BoardType currentBoard;
 		for (size_t x = 0; x < currentBoard.size(); x++) {
 			//Store the current row being read
-			std::array<std::int8_t, Board::NUM_COLS> currentRow;
+			std::array<std::int8_t, BoardT::NUM_COLS> currentRow;
 
 			//Get all of the values in this row
 			for (size_t y = 0; y < currentRow.size(); y++) {
@@ -48,7 +363,11 @@ void FileManager::readAIData(AI & ai)
 		}
 
 		//Read the priority data that is mapped to the board
-		std::map<std::uint8_t, std::uint8_t> currentPriority;
+		typename AI<BoardT>::PriorityList currentPriority;
+		currentPriority.priorities.fill(0);
+		currentPriority.legalMoves = 0;
+		currentPriority.visits = 0;
+
 		while (true) {
 			std::uint8_t currentCol;
 			std::uint8_t currentPriorityNum;
@@ -66,63 +385,453 @@ void FileManager::readAIData(AI & ai)
 				break;
 			}
 
-			currentPriority.emplace(currentCol, currentPriorityNum);
+			if (currentCol < BoardT::NUM_COLS) {
+				currentPriority.priorities[currentCol] = currentPriorityNum;
+				currentPriority.legalMoves |= 1 << currentCol;
+			}
+		}
+
+		keyBoard.setBoard(currentBoard);
+		data.emplace(keyBoard.getKey(), currentPriority);
+	}
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::writeAIData(const AI<BoardT>& ai)
+{
+	//The changes are forgotten as each shard is written, since the data file holds them
+	return writeData(*ai.getSharedData());
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::writeData(typename AI<BoardT>::DataType& data)
+{
+	//Write to a temporary file of our own, so the old data survives until the new data is complete
+	AtomicFile output(filename);
+
+	//Make sure the file opened properly
+	if (!output.isOpen()) {
+		std::cout << "\nERROR: Could not create a temporary file for " << filename << "\n";
+		return false;
+	}
+
+	//Leave space for the header, which needs the checksum of the index
+	std::array<char, HEADER_SIZE> header{};
+	output.write(header.data(), HEADER_SIZE);
+
+	std::vector<char> section;
+	std::vector<char> index;
+	std::uint64_t numRecords = 0;
+	std::uint64_t fileSize = HEADER_SIZE;
+
+	//Serialize one shard at a time, so only one shard's boards are ever copied and sorted at once while the rest of the table keeps changing
+	lockTimes.add(data.forEachShardSnapshot([&](const typename AI<BoardT>::DataType::TableType& table) {
+		const std::uint64_t sectionRecords = encodeSection(table, section);
+
+		if (sectionRecords != 0) {
+			const std::size_t entryStart = index.size();
+			index.resize(entryStart + INDEX_ENTRY_SIZE);
+			storeLittleEndian(index.data() + entryStart, fileSize, 8);
+			storeLittleEndian(index.data() + entryStart + 8, sectionRecords, 8);
+			storeLittleEndian(index.data() + entryStart + 16, section.size(), 8);
+			storeLittleEndian(index.data() + entryStart + 24, updateChecksum(0, section.data(), section.size()), 8);
+
+			output.write(section.data(), section.size());
+			numRecords += sectionRecords;
+			fileSize += section.size();
 		}
+	}));
+
+	const std::uint64_t checksum = updateChecksum(0, index.data(), index.size());
+
+	std::array<char, TRAILER_SIZE> trailer;
+	storeLittleEndian(trailer.data(), fileSize, 8);
+	storeLittleEndian(trailer.data() + 8, index.size() / INDEX_ENTRY_SIZE, 8);
+
+	output.write(index.data(), index.size());
+	output.write(trailer.data(), TRAILER_SIZE);
+	fileSize += index.size() + TRAILER_SIZE;
+
+	//Fill in the header now that the records are known
+	std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+	storeLittleEndian(header.data() + 4, VERSION, 2);
+	header[8] = static_cast<char>(BoardT::NUM_ROWS);
+	header[9] = static_cast<char>(BoardT::NUM_COLS);
+	header[10] = static_cast<char>(BoardT::CONNECT_N);
+	storeLittleEndian(header.data() + 16, numRecords, 8);
+	storeLittleEndian(header.data() + 24, checksum, 8);
+	output.writeAt(0, header.data(), HEADER_SIZE);
+
+	//Flush the file to the disk and replace the original file with it
+	if (!output.commit()) {
+		std::cout << "\nERROR: Could not write file " << filename << "\n";
+
+		//The changes were taken from the table as the shards were copied, so only a new data file can hold them now
+		hasBase = false;
+		return false;
+	}
+
+	hasBase = true;
+	baseChecksum = checksum;
+	baseSize = fileSize;
+	lastBytesWritten = fileSize;
+
+	//The journal now follows on from a different data file, so it would be ignored anyway
+	std::remove(getJournalFilename().c_str());
+	journalSize = 0;
+
+	return true;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::appendChanges(const AI<BoardT>& ai)
+{
+	if (needsFullWrite()) {
+		//There is no data file for a journal to follow on from yet, or the journal is too large
+		return writeAIData(ai);
+	}
+
+	const std::uint64_t numRecords = encodeChanges(*ai.getSharedData(), journalRecords);
 
-		data.emplace(currentBoard, currentPriority);
+	if (!appendRecords(journalRecords, numRecords) || needsFullWrite()) {
+		//Either the changes could not be written, and have already been taken from the table, or the journal has grown too large
+		return writeAIData(ai);
 	}
 
-	ai.rememberData(data);
+	return true;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::appendRecords(const std::vector<char>& records, const std::uint64_t& numRecords)
+{
+	lastBytesWritten = 0;
+
+	if (numRecords == 0) {
+		//Nothing has changed
+		return true;
+	}
+
+	AppendFile journal(getJournalFilename());
+
+	//The journal header (for a new journal) and the batch header go before the records
+	std::vector<char> prefix;
+
+	if (journal.isOpen() && journal.size() == 0) {
+		prefix.resize(HEADER_SIZE, 0);
+		std::copy(JOURNAL_MAGIC.begin(), JOURNAL_MAGIC.end(), prefix.begin());
+		storeLittleEndian(prefix.data() + 4, JOURNAL_VERSION, 2);
+		storeLittleEndian(prefix.data() + 6, RECORD_SIZE, 2);
+		prefix[8] = static_cast<char>(BoardT::NUM_ROWS);
+		prefix[9] = static_cast<char>(BoardT::NUM_COLS);
+		prefix[10] = static_cast<char>(BoardT::CONNECT_N);
+		storeLittleEndian(prefix.data() + 24, baseChecksum, 8);
+	}
+
+	//Every batch of changes starts with the number of records and their checksum, so a batch cut short by a crash can be found
+	const std::size_t batchStart = prefix.size();
+	prefix.resize(batchStart + RECORD_SIZE, 0);
+	storeLittleEndian(prefix.data() + batchStart, numRecords, 8);
+	storeLittleEndian(prefix.data() + batchStart + 8, updateChecksum(0, records.data(), records.size()), 8);
+
+	if (!journal.write(prefix.data(), prefix.size()) || !journal.write(records.data(), records.size()) || !journal.sync()) {
+		std::cout << "\nERROR: Could not write file " << getJournalFilename() << "\n";
+
+		//The journal may now end in a broken batch, so only a new data file can be trusted
+		hasBase = false;
+		return false;
+	}
+
+	journalSize = journal.size();
+	lastBytesWritten = prefix.size() + records.size();
+	return true;
+}
+
+template <class BoardT>
+std::uint64_t FileManager<BoardT>::encodeChanges(typename AI<BoardT>::DataType& data, std::vector<char>& records)
+{
+	records.clear();
+	records.reserve(data.numChanges() * RECORD_SIZE);
+
+	std::uint64_t numRecords = 0;
+	lockTimes.add(data.takeChanges([&](const typename BoardT::KeyType& key, const typename AI<BoardT>::PriorityList* priorityList) {
+		const std::size_t recordStart = records.size();
+		records.resize(recordStart + RECORD_SIZE, 0);
+		char* record = records.data() + recordStart;
+
+		if (priorityList == nullptr) {
+			storeLittleEndian(record, key | ERASED_FLAG, sizeof(key));
+		}
+		else {
+			storeLittleEndian(record, key, sizeof(key));
+			std::copy(priorityList->priorities.begin(), priorityList->priorities.end(), record + sizeof(key));
+		}
+
+		numRecords++;
+	}));
+
+	return numRecords;
+}
+
+template <class BoardT>
+void FileManager<BoardT>::replayJournal(typename AI<BoardT>::DataType& data)
+{
+	const std::string journalFilename = getJournalFilename();
+
+	std::ifstream input;
+	input.open(journalFilename, std::ifstream::in | std::ifstream::binary);
+
+	if (!input.is_open()) {
+		//Nothing has changed since the data file was written
+		return;
+	}
+
+	std::error_code error;
+	const std::uint64_t journalSize = std::filesystem::file_size(journalFilename, error);
+
+	std::array<char, HEADER_SIZE> header;
+	input.read(header.data(), HEADER_SIZE);
+
+	const bool valid = !error && input.gcount() == static_cast<std::streamsize>(HEADER_SIZE)
+		&& std::equal(JOURNAL_MAGIC.begin(), JOURNAL_MAGIC.end(), header.begin())
+		&& loadLittleEndian(header.data() + 4, 2) == JOURNAL_VERSION
+		&& loadLittleEndian(header.data() + 6, 2) == RECORD_SIZE
+		&& static_cast<std::uint8_t>(header[8]) == BoardT::NUM_ROWS
+		&& static_cast<std::uint8_t>(header[9]) == BoardT::NUM_COLS
+		&& static_cast<std::uint8_t>(header[10]) == BoardT::CONNECT_N
+		&& loadLittleEndian(header.data() + 24, 8) == baseChecksum;
+
+	if (!valid) {
+		//The journal was written after another data file, most likely just before that file was replaced
+		input.close();
+		std::remove(journalFilename.c_str());
+		return;
+	}
+
+	std::uint64_t validSize = HEADER_SIZE;
+	std::uint64_t numChanges = 0;
+	std::vector<char> batch;
+
+	while (true) {
+		std::array<char, RECORD_SIZE> batchHeader;
+		input.read(batchHeader.data(), RECORD_SIZE);
+
+		if (input.gcount() != static_cast<std::streamsize>(RECORD_SIZE)) {
+			break;
+		}
+
+		const std::uint64_t numRecords = loadLittleEndian(batchHeader.data(), 8);
+		const std::uint64_t expectedChecksum = loadLittleEndian(batchHeader.data() + 8, 8);
+
+		if (numRecords > (journalSize - validSize) / RECORD_SIZE) {
+			break;
+		}
+
+		batch.resize(static_cast<std::size_t>(numRecords * RECORD_SIZE));
+		input.read(batch.data(), batch.size());
+
+		if (input.gcount() != static_cast<std::streamsize>(batch.size()) || updateChecksum(0, batch.data(), batch.size()) != expectedChecksum) {
+			break;
+		}
+
+		//Only apply a batch once all of it is known to be intact
+		for (std::size_t x = 0; x < numRecords; x++) {
+			const char* record = batch.data() + x * RECORD_SIZE;
+			const typename BoardT::KeyType storedKey = loadLittleEndian(record, sizeof(typename BoardT::KeyType));
+			const typename BoardT::KeyType key = storedKey & ~ERASED_FLAG;
+
+			if (key == AI<BoardT>::DataType::TableType::EMPTY_KEY) {
+				continue;
+			}
+
+			if (storedKey & ERASED_FLAG) {
+				data.erase(key);
+			}
+			else {
+				const typename AI<BoardT>::PriorityList priorityList = decodePriorities(key, record);
+
+				data.withShard(key, [&](typename AI<BoardT>::DataType::TableType& table) {
+					*table.emplace(key, priorityList).first = priorityList;
+				});
+			}
+		}
+
+		validSize += RECORD_SIZE + batch.size();
+		numChanges += numRecords;
+	}
 
 	input.close();
+	this->journalSize = validSize;
+
+	if (validSize < journalSize) {
+		//Cut off the batch that was being written when the program stopped, so new batches can be found after the intact ones
+		std::cout << "\nDiscarding an incomplete change in " << journalFilename;
+		std::filesystem::resize_file(journalFilename, validSize, error);
+
+		if (error) {
+			//New changes would be lost behind the broken batch, so the next save must write the whole data file
+			hasBase = false;
+		}
+	}
+
+	std::cout << "\nReplayed " << numChanges << " changes from " << journalFilename;
 }
 
-void FileManager::writeAIData(AI & ai)
+template <class BoardT>
+typename AI<BoardT>::PriorityList FileManager<BoardT>::decodePriorities(const typename BoardT::KeyType& key, const char* record)
 {
-	//Create and open a temporary output file
-	std::ofstream output;
+	typename AI<BoardT>::PriorityList priorityList;
+	priorityList.legalMoves = BoardT::legalMovesOfKey(key);
+	priorityList.visits = 0;
 
-	output.open("temp.txt", std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		//Columns that cannot be played must keep a priority of 0
+		const bool legal = (priorityList.legalMoves >> col) & 1;
+		priorityList.priorities[col] = legal ? static_cast<std::uint8_t>(record[sizeof(key) + col]) : 0;
+	}
 
-	//Make sure the file opened properly
-	if (!output.is_open()) {
-		//The file likely did not open because it does not exist, so we will make it instead
-		output.open("temp.txt", std::ofstream::out | std::ofstream::binary);
+	return priorityList;
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::readFrozenModel(AI<BoardT>& ai)
+{
+	const std::string modelFilename = getModelFilename();
+
+	std::error_code dataError;
+	std::error_code journalError;
+	std::error_code modelError;
+	const auto dataTime = std::filesystem::last_write_time(filename, dataError);
+	const auto journalTime = std::filesystem::last_write_time(getJournalFilename(), journalError);
+	const auto modelTime = std::filesystem::last_write_time(modelFilename, modelError);
 
-		if (!output.is_open()) {
-			//Something is wrong
-			std::cout << "\nERROR: Could not open file " << filename;
-			return;
+	//Changes saved to the journal since the last full save leave the data file untouched, so the journal must be checked as well
+	if (modelError || (!dataError && modelTime < dataTime) || (!journalError && modelTime < journalTime)) {
+		//The model is missing or out of date, so build it from the data once
+		if (!readAIData(ai)) {
+			//A model built from nothing would hide the damaged data until the data file changed again
+			return false;
 		}
+
+		if (!FrozenModel<BoardT>::write(modelFilename, *ai.getSharedData())) {
+			//The AI can still play from the data it has read
+			std::cout << "\nERROR: Could not write file " << modelFilename << "\n";
+			return false;
+		}
+
+		//The data is not needed once the model has been written
+		ai.getSharedData()->clear();
+	}
+
+	auto model = std::make_shared<FrozenModel<BoardT>>();
+
+	if (!model->open(modelFilename)) {
+		std::cout << "\nERROR: Could not open file " << modelFilename << "\n";
+		return false;
+	}
+
+	ai.useFrozenModel(model);
+	return true;
+}
+
+template <class BoardT>
+std::uint64_t FileManager<BoardT>::encodeSection(const typename AI<BoardT>::DataType::TableType& table, std::vector<char>& section)
+{
+	typedef typename AI<BoardT>::DataType::TableType::Slot SlotType;
+
+	//Sorting the boards makes the differences between neighbouring keys small
+	std::vector<const SlotType*> slots;
+	slots.reserve(table.size());
+	for (auto& slot : table) {
+		slots.push_back(&slot);
 	}
 
-	//Create a variable to hold all of the data we are going to write
-	std::map<Board::BoardType, std::map<std::uint8_t, std::uint8_t>> dataToWrite = ai.getData();
+	std::sort(slots.begin(), slots.end(), [](const SlotType* first, const SlotType* second) { return first->key < second->key; });
+
+	section.clear();
+	typename BoardT::KeyType previousKey = 0;
+
+	for (auto slot : slots) {
+		appendVarint(section, slot->key - previousKey);
+		previousKey = slot->key;
+
+		//Bit n of the mask is set if column n is stored, which is only the case for legal columns that have changed from their starting priority
+		const std::uint8_t legalMoves = BoardT::legalMovesOfKey(slot->key);
+		std::uint8_t storedColumns = 0;
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			const bool changed = slot->value.priorities[col] != AI<BoardT>::PRIORITY_INIT_VALUE;
+			storedColumns |= static_cast<std::uint8_t>(((legalMoves >> col) & 1) && changed) << col;
+		}
+
+		section.push_back(static_cast<char>(storedColumns));
 
-	//Loop through all of the pairs of boards and priorities within the map
-	for (auto& boardsAndPrioritiesPair : dataToWrite) {
-		//Write the current board to the file
-		for (auto& row : boardsAndPrioritiesPair.first) {
-			for (auto& elem : row) {
-				output << elem;
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			if ((storedColumns >> col) & 1) {
+				section.push_back(static_cast<char>(slot->value.priorities[col]));
 			}
 		}
+	}
+
+	return slots.size();
+}
+
+template <class BoardT>
+bool FileManager<BoardT>::decodeSection(const char* payload, const std::size_t& size, const std::uint64_t& numRecords, typename AI<BoardT>::DataType& data)
+{
+	const char* position = payload;
+	const char* end = payload + size;
+	typename BoardT::KeyType key = 0;
+
+	for (std::uint64_t x = 0; x < numRecords; x++) {
+		std::uint64_t keyDifference;
+
+		//Keys are unique and sorted, so every difference is at least 1
+		if (!loadVarint(position, end, keyDifference) || keyDifference == 0 || position == end) {
+			return false;
+		}
+
+		key += keyDifference;
+
+		typename AI<BoardT>::PriorityList priorityList;
+		priorityList.legalMoves = BoardT::legalMovesOfKey(key);
+		priorityList.visits = 0;
+
+		const std::uint8_t storedColumns = static_cast<std::uint8_t>(*position++);
+		if (storedColumns & ~priorityList.legalMoves) {
+			//Only legal columns are ever stored
+			return false;
+		}
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			priorityList.priorities[col] = (priorityList.legalMoves >> col) & 1 ? AI<BoardT>::PRIORITY_INIT_VALUE : 0;
+
+			if ((storedColumns >> col) & 1) {
+				if (position == end) {
+					return false;
+				}
 
-		//Write the priority pair list to the file
-		for (auto& columnAndPriorityValuePair : boardsAndPrioritiesPair.second) {
-			output << columnAndPriorityValuePair.first << columnAndPriorityValuePair.second;
+				priorityList.priorities[col] = static_cast<std::uint8_t>(*position++);
+			}
 		}
 
-		//Write the end character so we'll know to stop here when reading
-		output << END_CHAR;
+		data.emplace(key, priorityList);
+	}
+
+	return position == end;
+}
+
+template <class BoardT>
+std::uint64_t FileManager<BoardT>::updateChecksum(std::uint64_t checksum, const char* bytes, const std::size_t& size)
+{
+	//Every 8 bytes are mixed in as a 64 bit word with a multiply that spreads every bit of the word over the checksum
+	for (std::size_t x = 0; x < size; x += 8) {
+		checksum = (checksum ^ loadLittleEndian(bytes + x, std::min<std::size_t>(size - x, 8))) * 0x100000001B3ull;
+		checksum ^= checksum >> 29;
 	}
 
-	//Flush and close the file
-	output.flush();
-	output.close();
+	return checksum;
+}
 
-	//Delete the original file
-	std::remove(filename.c_str());
-	//Rename the temporary file to the original file's name
-	std::rename("temp.txt", filename.c_str());
-}
\ No newline at end of file
+template class FileManager<Board4x5>;
+template class FileManager<Board5x6>;
+template class FileManager<Board6x7>;
@@ -1,27 +1,284 @@
 #pragma once
+#include <array>
 #include <fstream>
 #include <string>
+#include <vector>
 #include "AI.h"
 
+/*
+Reads and writes the learned data of AI objects
+Data is stored in a versioned binary format: a header, one section of compressed boards per shard of the AI's table, and an index of the sections
+Within a section the boards are sorted, their keys are stored as the varint difference from the key before, and only the priorities that differ from PRIORITY_INIT_VALUE are stored
+The index gives the position, size and checksum of every section, so the sections are read and checked on every core at once
+Files with sections but no index (version 3) and fixed-size records (version 2) are still read, one block at a time
+Changes can also be appended to a journal next to the data file, which is replayed when the data is read and compacted into the data file from time to time
+Files in the original format, which has no header, are still read and are converted the first time they are loaded
+@param BoardT The type of board the AI objects play on
+*/
+template <class BoardT>
 class FileManager
 {
 public:
+	//Ends every board in the original format, which is why that format cannot store a priority of 254
 	const std::uint8_t END_CHAR = 254;
 
+	//The first bytes of every file in the versioned format
+	static constexpr std::array<char, 4> MAGIC = { 'C', '4', 'A', 'I' };
+	static constexpr std::uint16_t VERSION = 4;
+
+	//The version where sections start with their own header instead of being listed in an index
+	static constexpr std::uint16_t UNINDEXED_VERSION = 3;
+
+	//The version where every board is a fixed-size record
+	static constexpr std::uint16_t FIXED_RECORD_VERSION = 2;
+
+	//The header holds the magic, version, record size (0 if records vary in size), board dimensions, record count and a checksum
+	//The checksum covers the index in the current version, which holds the checksum of every section, and everything after the header before that
+	static constexpr std::size_t HEADER_SIZE = 32;
+
+	//Every fixed-size record (and journal record) is the key of a board followed by one priority per column, padded to 8 columns
+	static constexpr std::size_t RECORD_SIZE = 16;
+
+	//Every section of a version 3 file starts with its number of boards and its size in bytes
+	static constexpr std::size_t SECTION_HEADER_SIZE = 16;
+
+	//Every entry of the index holds the position, number of boards, size in bytes and checksum of a section
+	static constexpr std::size_t INDEX_ENTRY_SIZE = 32;
+
+	//The file ends with the position of the index and its number of entries
+	static constexpr std::size_t TRAILER_SIZE = 16;
+
+	//The number of records read or written with each call to the stream
+	static constexpr std::size_t RECORDS_PER_BLOCK = 65536;
+
+	static_assert(BoardT::NUM_COLS <= RECORD_SIZE - sizeof(typename BoardT::KeyType), "The priorities of a board must fit within a record");
+
+	//The first bytes of every journal, which holds the changes made since the data file was written
+	static constexpr std::array<char, 4> JOURNAL_MAGIC = { 'C', '4', 'J', 'N' };
+	static constexpr std::uint16_t JOURNAL_VERSION = 1;
+
+	//Set on the key of a journal record to mark a board that has been erased
+	static constexpr typename BoardT::KeyType ERASED_FLAG = static_cast<typename BoardT::KeyType>(1) << 63;
+
+	//The journal is compacted into the data file once it is larger than 1 / JOURNAL_COMPACT_DIVISOR of the data file
+	static constexpr std::uint64_t JOURNAL_COMPACT_DIVISOR = 2;
+
+	static_assert(BoardT::COL_HEIGHT * BoardT::NUM_COLS < 64, "Keys must leave the top bit free for ERASED_FLAG");
+
 	FileManager(const std::string& filename);
 
 	/*
 	Reads data from the file for the given AI and automatically sets it
+	Files in the original format are rewritten in the current format once they have been read
+	The journal is replayed on top of the data if it was written after the data file
+	The table is left empty if the file does not exist or could not be read
 	@param ai The AI to read data for
+	@return bool true if the file was read or does not exist yet or false if it exists but could not be read, in which case it must not be overwritten
 	*/
-	void readAIData(AI& ai);
+	bool readAIData(AI<BoardT>& ai);
 
 	/*
 	Writes data from the file for the given AI. A temporary copy file is created to avoid losing data
+	The data is written straight from the AI's table one shard at a time, so another thread may keep changing it if the table is concurrent
+	Everything in the journal is now in the data file, so the journal is deleted
 	@param ai The AI to write data for
+	@return bool true if the file was replaced or false if the original file was left as it was
+	*/
+	bool writeAIData(const AI<BoardT>& ai);
+
+	/*
+	Appends every board the AI has changed since the last save to the journal, so a save costs as much as the changes rather than the whole table
+	The AI's table must be tracking changes, and a concurrent table can keep changing while this runs, since each shard's changes are taken while it is locked
+	The whole file is written instead if it has not been read or written yet, or once the journal has grown too large
+	@param ai The AI to write the changes of
+	@return bool true if the changes were saved or false otherwise
+	*/
+	bool appendChanges(const AI<BoardT>& ai);
+
+	/*
+	Writes the given table as the whole data file and forgets the changes it records, since the file holds them
+	A concurrent table can keep changing while it is written, since each shard is copied on its own (see ShardedPositionTable::forEachShardSnapshot)
+	@param data The table to write
+	@return bool true if the file was replaced or false if the original file was left as it was
+	*/
+	bool writeData(typename AI<BoardT>::DataType& data);
+
+	/*
+	Returns true if the next save must write the whole data file instead of appending to the journal
+	This is the case before the data file has been read or written, after the journal failed, and once the journal has grown too large
+	@return bool true if the whole data file needs to be written
+	*/
+	inline const bool needsFullWrite() const { return !hasBase || journalSize > baseSize / JOURNAL_COMPACT_DIVISOR; }
+
+	/*
+	Returns the number of bytes written by the last save
+	@return std::uint64_t The number of bytes
+	*/
+	inline const std::uint64_t getLastBytesWritten() const { return lastBytesWritten; }
+
+	/*
+	Returns how long the saves since the last call kept the shards of a concurrent table locked, which threads using those shards may have waited for
+	@return LockTimes The lock times, which start again from 0
+	*/
+	inline typename AI<BoardT>::DataType::LockTimes takeLockTimes() {
+		const auto times = lockTimes;
+		lockTimes = typename AI<BoardT>::DataType::LockTimes();
+		return times;
+	}
+
+	/*
+	Returns the number of bytes of the data file read by the last call to readAIData
+	@return std::uint64_t The number of bytes
+	*/
+	inline const std::uint64_t getLastBytesRead() const { return lastBytesRead; }
+
+	/*
+	Returns the time the last call to readAIData took to read the data file, not counting the journal
+	@return double The time in seconds
+	*/
+	inline const double getLastReadSeconds() const { return lastReadSeconds; }
+
+	/*
+	Makes the given AI play from a memory-mapped model of this file's data instead of reading the data
+	The model is kept next to the data file and is rebuilt from the data first if it is missing or older than the data file or its journal
+	@param ai The AI that will use the model
+	@return bool true if the model is being used or false if the data could not be read or the model could not be built or opened
+	*/
+	bool readFrozenModel(AI<BoardT>& ai);
+
+	/*
+	Returns the name of the data file
+	@return std::string The name of the data file
+	*/
+	inline const std::string getFilename() const { return filename; }
+
+	/*
+	Returns the name of the model file kept next to the data file
+	@return std::string The name of the model file
 	*/
-	void writeAIData(AI& ai);
+	inline const std::string getModelFilename() const { return filename + ".model"; }
+
+	/*
+	Returns the name of the journal kept next to the data file
+	@return std::string The name of the journal
+	*/
+	inline const std::string getJournalFilename() const { return filename + ".journal"; }
 
 private:
 	std::string filename;
-};
\ No newline at end of file
+
+	//true once the data file has been read or written by this object, which the journal must follow on from
+	bool hasBase;
+
+	//The checksum of the data file, which ties the journal to the data file it follows on from
+	std::uint64_t baseChecksum;
+
+	//The size of the data file in bytes
+	std::uint64_t baseSize;
+
+	//The size of the journal, which is 0 if there is no journal
+	std::uint64_t journalSize;
+
+	std::uint64_t lastBytesWritten;
+	std::uint64_t lastBytesRead;
+	double lastReadSeconds;
+
+	//The changes taken from the table for the journal, which keeps its memory between saves
+	std::vector<char> journalRecords;
+
+	//How long saves have kept the table's shards locked since takeLockTimes was last called
+	typename AI<BoardT>::DataType::LockTimes lockTimes;
+
+	/*
+	Appends records made by encodeChanges to the journal as one batch
+	@param records The records
+	@param numRecords The number of records
+	@return bool true if the records were saved or false if the whole data file now needs to be written
+	*/
+	bool appendRecords(const std::vector<char>& records, const std::uint64_t& numRecords);
+
+	/*
+	Takes every change recorded by the given table and converts them into journal records
+	@param data The table, which must be tracking changes
+	@param records Set to the records
+	@return std::uint64_t The number of records
+	*/
+	std::uint64_t encodeChanges(typename AI<BoardT>::DataType& data, std::vector<char>& records);
+
+	/*
+	Applies the changes in the journal to the given table, cutting off any changes that were only partly written
+	A journal written after a different data file is deleted instead
+	@param data The table read from the data file
+	*/
+	void replayJournal(typename AI<BoardT>::DataType& data);
+
+	/*
+	Converts a record into a priority list
+	@param key The key stored in the record
+	@param record The bytes of the record
+	@return PriorityList The priorities, with 0 for every column that cannot be played
+	*/
+	static typename AI<BoardT>::PriorityList decodePriorities(const typename BoardT::KeyType& key, const char* record);
+
+	/*
+	Reads the sections of a file in the current format directly into the given table, using one thread per core
+	@param input The file, positioned after the header
+	@param header The HEADER_SIZE bytes of the header
+	@param data The table to fill
+	@return bool true if the file was read or false if it was invalid
+	*/
+	bool readIndexedSections(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data);
+
+	/*
+	Reads the sections of a version 3 file, which have no index, directly into the given table
+	@param input The file, positioned after the header
+	@param header The HEADER_SIZE bytes of the header
+	@param data The table to fill
+	@return bool true if the file was read or false if it was invalid
+	*/
+	bool readSections(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data);
+
+	/*
+	Reads the fixed-size records of a version 2 file directly into the given table
+	@param input The file, positioned after the header
+	@param header The HEADER_SIZE bytes of the header
+	@param data The table to fill
+	@return bool true if the file was read or false if it was invalid
+	*/
+	bool readRecords(std::ifstream& input, const char* header, typename AI<BoardT>::DataType& data);
+
+	/*
+	Compresses the boards of one shard into a section
+	@param table The table of the shard
+	@param section Set to the compressed boards
+	@return std::uint64_t The number of boards in the section
+	*/
+	static std::uint64_t encodeSection(const typename AI<BoardT>::DataType::TableType& table, std::vector<char>& section);
+
+	/*
+	Decompresses the boards of a section into the given table
+	@param payload The compressed boards
+	@param size The size of the compressed boards in bytes
+	@param numRecords The number of boards in the section
+	@param data The table to add the boards to
+	@return bool true if the section was valid or false otherwise
+	*/
+	static bool decodeSection(const char* payload, const std::size_t& size, const std::uint64_t& numRecords, typename AI<BoardT>::DataType& data);
+
+	/*
+	Reads a file in the original format, where every board is written out in full and followed by (column, priority) pairs
+	@param input The file, positioned at the start
+	@param data The table to fill
+	*/
+	void readLegacyData(std::ifstream& input, typename AI<BoardT>::DataType& data);
+
+	/*
+	Mixes a block of bytes into a running checksum
+	A block that is not a multiple of 8 bytes long is padded, so files must be checked in the same blocks they were written in
+	@param checksum The checksum so far
+	@param bytes The bytes
+	@param size The number of bytes
+	@return std::uint64_t The new checksum
+	*/
+	static std::uint64_t updateChecksum(std::uint64_t checksum, const char* bytes, const std::size_t& size);
+};
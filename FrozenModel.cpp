@@ -0,0 +1,168 @@
+#include "FrozenModel.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+
+namespace
+{
+	/*
+	Maps the whole of the given file into memory for reading
+	@param filename The file to map
+	@param size Set to the size of the file
+	@return void* The start of the mapping or nullptr if the file could not be mapped
+	*/
+	void* mapFile(const std::string& filename, std::size_t& size) {
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return nullptr;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		HANDLE mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+
+		if (mappingHandle == nullptr) {
+			return nullptr;
+		}
+
+		//The view keeps the mapping alive after its handle is closed
+		void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mappingHandle);
+
+		size = static_cast<std::size_t>(fileSize.QuadPart);
+		return view;
+	}
+
+	/*
+	Unmaps a mapping returned by mapFile
+	@param mapping The start of the mapping
+	@param size The size of the mapping
+	*/
+	void unmapFile(void* mapping, const std::size_t& size) {
+		UnmapViewOfFile(mapping);
+	}
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	/*
+	Maps the whole of the given file into memory for reading
+	@param filename The file to map
+	@param size Set to the size of the file
+	@return void* The start of the mapping or nullptr if the file could not be mapped
+	*/
+	void* mapFile(const std::string& filename, std::size_t& size) {
+		const int file = ::open(filename.c_str(), O_RDONLY);
+		if (file < 0) {
+			return nullptr;
+		}
+
+		struct stat fileStatus;
+		if (fstat(file, &fileStatus) != 0 || fileStatus.st_size == 0) {
+			::close(file);
+			return nullptr;
+		}
+
+		//A shared mapping lets every process playing from the same file use the same pages
+		void* view = mmap(nullptr, static_cast<std::size_t>(fileStatus.st_size), PROT_READ, MAP_SHARED, file, 0);
+		::close(file);
+
+		if (view == MAP_FAILED) {
+			return nullptr;
+		}
+
+		//Lookups jump around the file, so reading ahead would only waste memory
+		madvise(view, static_cast<std::size_t>(fileStatus.st_size), MADV_RANDOM);
+
+		size = static_cast<std::size_t>(fileStatus.st_size);
+		return view;
+	}
+
+	/*
+	Unmaps a mapping returned by mapFile
+	@param mapping The start of the mapping
+	@param size The size of the mapping
+	*/
+	void unmapFile(void* mapping, const std::size_t& size) {
+		munmap(mapping, size);
+	}
+}
+#endif
+
+template <class BoardT>
+constexpr std::array<char, 4> FrozenModel<BoardT>::MAGIC;
+
+template <class BoardT>
+FrozenModel<BoardT>::FrozenModel()
+	: records(nullptr), numRecords(0), mapping(nullptr), mappingSize(0)
+{}
+
+template <class BoardT>
+FrozenModel<BoardT>::~FrozenModel()
+{
+	close();
+}
+
+template <class BoardT>
+bool FrozenModel<BoardT>::open(const std::string& filename)
+{
+	close();
+
+	std::size_t size = 0;
+	void* view = mapFile(filename, size);
+
+	if (view == nullptr) {
+		return false;
+	}
+
+	const char* header = static_cast<const char*>(view);
+	const std::uint64_t count = size >= HEADER_SIZE ? loadLittleEndian(header + 16, 8) : 0;
+
+	const bool valid = size >= HEADER_SIZE
+		&& std::equal(MAGIC.begin(), MAGIC.end(), header)
+		&& loadLittleEndian(header + 4, 2) == VERSION
+		&& loadLittleEndian(header + 6, 2) == RECORD_SIZE
+		&& static_cast<std::uint8_t>(header[8]) == BoardT::NUM_ROWS
+		&& static_cast<std::uint8_t>(header[9]) == BoardT::NUM_COLS
+		&& static_cast<std::uint8_t>(header[10]) == BoardT::CONNECT_N
+		&& count <= (size - HEADER_SIZE) / RECORD_SIZE;
+
+	if (!valid) {
+		unmapFile(view, size);
+		return false;
+	}
+
+	mapping = view;
+	mappingSize = size;
+	records = header + HEADER_SIZE;
+	numRecords = static_cast<std::size_t>(count);
+	return true;
+}
+
+template <class BoardT>
+void FrozenModel<BoardT>::close()
+{
+	if (mapping != nullptr) {
+		unmapFile(mapping, mappingSize);
+	}
+
+	records = nullptr;
+	numRecords = 0;
+	mapping = nullptr;
+	mappingSize = 0;
+}
+
+template class FrozenModel<Board4x5>;
+template class FrozenModel<Board5x6>;
+template class FrozenModel<Board6x7>;
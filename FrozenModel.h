@@ -0,0 +1,151 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AtomicFile.h"
+#include "Board.h"
+#include "ByteOrder.h"
+
+/*
+A read-only copy of an AI's learned data that is mapped into memory instead of being read
+The file is a header followed by fixed-size records sorted by key, so boards are found with a binary search directly in the mapping
+Nothing is parsed or allocated to open or use a model, and every process that maps the same file shares its pages
+@param BoardT The type of board the model was learned on
+*/
+template <class BoardT>
+class FrozenModel
+{
+public:
+	typedef typename BoardT::KeyType KeyType;
+	typedef std::array<std::uint8_t, BoardT::NUM_COLS> PrioritiesType;
+
+	//The first bytes of every model file
+	static constexpr std::array<char, 4> MAGIC = { 'C', '4', 'F', 'M' };
+	static constexpr std::uint16_t VERSION = 1;
+
+	//The header holds the magic, version, record size, board dimensions and record count
+	static constexpr std::size_t HEADER_SIZE = 32;
+
+	//Every record is the key of a board followed by one priority per column, padded to 8 columns
+	static constexpr std::size_t RECORD_SIZE = 16;
+
+	static_assert(BoardT::NUM_COLS <= RECORD_SIZE - sizeof(KeyType), "The priorities of a board must fit within a record");
+
+	FrozenModel();
+	~FrozenModel();
+
+	FrozenModel(const FrozenModel&) = delete;
+	FrozenModel& operator=(const FrozenModel&) = delete;
+
+	/*
+	Maps the given model file into memory, replacing any model that is already open
+	@param filename The file written by write
+	@return bool true if the file was mapped or false if it could not be opened or is not a valid model
+	*/
+	bool open(const std::string& filename);
+
+	/*
+	Unmaps the model
+	*/
+	void close();
+
+	inline const bool isOpen() const { return records != nullptr; }
+	inline const std::size_t size() const { return numRecords; }
+
+	/*
+	Copies the priorities stored for the given board
+	@param key The key of the board
+	@param priorities Set to the priority of every column if the board is found, with 0 for every column that cannot be played
+	@return bool true if the board was found or false otherwise
+	*/
+	inline bool find(const KeyType& key, PrioritiesType& priorities) const {
+		std::size_t low = 0;
+		std::size_t high = numRecords;
+
+		//Find the first record whose key is not less than the key being looked for
+		while (low < high) {
+			const std::size_t middle = low + (high - low) / 2;
+
+			if (keyAt(middle) < key) {
+				low = middle + 1;
+			}
+			else {
+				high = middle;
+			}
+		}
+
+		if (low == numRecords || keyAt(low) != key) {
+			return false;
+		}
+
+		const char* record = records + low * RECORD_SIZE;
+		const std::uint8_t legalMoves = BoardT::legalMovesOfKey(key);
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			priorities[col] = (legalMoves >> col) & 1 ? static_cast<std::uint8_t>(record[sizeof(KeyType) + col]) : 0;
+		}
+
+		return true;
+	}
+
+	/*
+	Writes the given data as a model file
+	@param filename The file to write
+	@param data The data to write, which must have a forEach function that passes every key and priority list
+	@return bool true if the file was written or false otherwise
+	*/
+	template <class DataType>
+	static bool write(const std::string& filename, const DataType& data) {
+		std::vector<std::pair<KeyType, PrioritiesType>> sortedData;
+		sortedData.reserve(data.size());
+
+		data.forEach([&](const KeyType& key, const auto& priorityList) {
+			sortedData.emplace_back(key, priorityList.priorities);
+		});
+
+		std::sort(sortedData.begin(), sortedData.end(), [](const std::pair<KeyType, PrioritiesType>& first, const std::pair<KeyType, PrioritiesType>& second) {
+			return first.first < second.first;
+		});
+
+		AtomicFile output(filename);
+
+		if (!output.isOpen()) {
+			return false;
+		}
+
+		std::array<char, HEADER_SIZE> header{};
+		std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+		storeLittleEndian(header.data() + 4, VERSION, 2);
+		storeLittleEndian(header.data() + 6, RECORD_SIZE, 2);
+		header[8] = static_cast<char>(BoardT::NUM_ROWS);
+		header[9] = static_cast<char>(BoardT::NUM_COLS);
+		header[10] = static_cast<char>(BoardT::CONNECT_N);
+		storeLittleEndian(header.data() + 16, sortedData.size(), 8);
+		output.write(header.data(), HEADER_SIZE);
+
+		std::vector<char> recordBytes(sortedData.size() * RECORD_SIZE, 0);
+		for (std::size_t x = 0; x < sortedData.size(); x++) {
+			char* record = recordBytes.data() + x * RECORD_SIZE;
+
+			storeLittleEndian(record, sortedData[x].first, sizeof(KeyType));
+			std::copy(sortedData[x].second.begin(), sortedData[x].second.end(), record + sizeof(KeyType));
+		}
+
+		output.write(recordBytes.data(), recordBytes.size());
+		return output.commit();
+	}
+
+private:
+	//The records within the mapping, or nullptr if no model is open
+	const char* records;
+	std::size_t numRecords;
+
+	//The whole mapped file
+	void* mapping;
+	std::size_t mappingSize;
+
+	inline KeyType keyAt(const std::size_t& index) const { return loadLittleEndian(records + index * RECORD_SIZE, sizeof(KeyType)); }
+};
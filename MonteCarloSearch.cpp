@@ -0,0 +1,355 @@
+#include "MonteCarloSearch.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+#include <utility>
+
+template <class BoardT>
+MonteCarloSearch<BoardT>::MonteCarloSearch(const std::int8_t& pieceToUse, const std::uint64_t& seed, const std::uint64_t& playoutsPerMove, const double& secondsPerMove,
+	const unsigned int& numThreads, const Parallelism& parallelism, const std::uint32_t& maxNodes)
+	: pieceBeingUsed(pieceToUse), playoutsPerMove(playoutsPerMove == 0 && secondsPerMove <= 0 ? DEFAULT_PLAYOUTS : playoutsPerMove), secondsPerMove(secondsPerMove),
+	numThreads(std::max(numThreads, 1u)), parallelism(parallelism), maxNodes(std::max<std::uint32_t>(maxNodes, 1))
+{
+	numTrees = parallelism == Parallelism::ROOT ? this->numThreads : 1;
+	trees.reset(new Tree[numTrees]);
+
+	//Every thread's generator is seeded from the one seed so a search can still be repeated on a single thread
+	Random seeds(seed);
+	for (unsigned int x = 0; x < this->numThreads; x++) {
+		randoms.emplace_back(seeds.next());
+	}
+}
+
+template <class BoardT>
+typename MonteCarloSearch<BoardT>::Result MonteCarloSearch<BoardT>::search(const BoardT& board)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	Result result;
+	for (unsigned int x = 0; x < numTrees; x++) {
+		result.reusedPlayouts += moveRootTo(trees[x], board, pieceBeingUsed);
+	}
+
+	std::atomic<std::uint64_t> claimedPlayouts(0);
+	std::atomic<std::uint64_t> finishedPlayouts(0);
+	std::atomic<bool> stop(false);
+
+	auto searchOnThread = [&](const unsigned int& thread) {
+		Tree& tree = trees[parallelism == Parallelism::ROOT ? thread : 0];
+		Random& random = randoms[thread];
+		std::uint64_t playouts = 0;
+
+		while (!stop.load(std::memory_order_relaxed)) {
+			if (playoutsPerMove > 0 && claimedPlayouts.fetch_add(1, std::memory_order_relaxed) >= playoutsPerMove) {
+				break;
+			}
+
+			if (secondsPerMove > 0 && playouts % CLOCK_CHECK_INTERVAL == 0
+				&& std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= secondsPerMove) {
+				stop = true;
+				break;
+			}
+
+			runPlayout(tree, random);
+			playouts++;
+		}
+
+		finishedPlayouts += playouts;
+	};
+
+	std::vector<std::thread> threads;
+	for (unsigned int x = 1; x < numThreads; x++) {
+		threads.emplace_back(searchOnThread, x);
+	}
+
+	searchOnThread(0);
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	result.playouts = finishedPlayouts;
+
+	//Add up each move's playouts across the trees, since each tree only saw a share of them
+	std::array<std::uint64_t, BoardT::NUM_COLS> visitsByMove{};
+	std::array<std::uint64_t, BoardT::NUM_COLS> scoreByMove{};
+
+	for (unsigned int x = 0; x < numTrees; x++) {
+		const Node& root = trees[x].nodes[0];
+
+		if (root.state.load(std::memory_order_acquire) == NodeState::EXPANDED) {
+			for (std::uint32_t child = root.firstChild; child < root.firstChild + root.numChildren; child++) {
+				const Node& node = trees[x].nodes[child];
+				visitsByMove[node.move] += node.visits;
+				scoreByMove[node.move] += node.score;
+			}
+		}
+
+		result.nodesUsed += std::min(trees[x].numNodes.load(), trees[x].capacity);
+	}
+
+	//The most played move is the most trusted, since a move only gets playouts by doing well
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		if (board.validMove(col) && (result.bestMove == NO_MOVE || visitsByMove[col] > visitsByMove[result.bestMove])) {
+			result.bestMove = col;
+		}
+	}
+
+	if (result.bestMove != NO_MOVE && visitsByMove[result.bestMove] > 0) {
+		result.winRate = scoreByMove[result.bestMove] / (2.0 * visitsByMove[result.bestMove]);
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+template <class BoardT>
+const std::uint8_t MonteCarloSearch<BoardT>::makeMove(BoardT& board)
+{
+	lastResult = search(board);
+	board.addPiece(lastResult.bestMove, pieceBeingUsed);
+
+	//Keep the tree below the chosen move, where the opponent's reply will be found next time
+	for (unsigned int x = 0; x < numTrees; x++) {
+		moveRootTo(trees[x], board, pieceBeingUsed == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE);
+	}
+
+	return lastResult.bestMove;
+}
+
+template <class BoardT>
+void MonteCarloSearch<BoardT>::clearTree()
+{
+	for (unsigned int x = 0; x < numTrees; x++) {
+		trees[x].numNodes = 0;
+	}
+}
+
+template <class BoardT>
+std::uint64_t MonteCarloSearch<BoardT>::moveRootTo(Tree& tree, const BoardT& board, const std::int8_t& player)
+{
+	if (tree.numNodes > 0 && tree.rootPlayer == player && tree.rootBoard.getKey() == board.getKey()) {
+		return tree.nodes[0].visits;
+	}
+
+	if (tree.numNodes > 0 && tree.rootPlayer != player && tree.nodes[0].state == NodeState::EXPANDED) {
+		const Node& root = tree.nodes[0];
+
+		for (std::uint32_t child = root.firstChild; child < root.firstChild + root.numChildren; child++) {
+			BoardT childBoard = tree.rootBoard;
+			childBoard.addPiece(tree.nodes[child].move, tree.rootPlayer);
+
+			if (childBoard.getKey() == board.getKey()) {
+				keepSubtree(tree, child);
+				tree.rootBoard = childBoard;
+				tree.rootPlayer = player;
+				return tree.nodes[0].visits;
+			}
+		}
+	}
+
+	//The pools are only allocated by the first search, so an unused search costs nothing
+	if (!tree.nodes) {
+		tree.capacity = std::max<std::uint32_t>(maxNodes / numTrees, 1);
+		tree.nodes.reset(new Node[tree.capacity]);
+		tree.spareNodes.reset(new Node[tree.capacity]);
+	}
+
+	//The board does not follow on from the tree, so start again
+	copyNode(tree.nodes[0], Node());
+	tree.numNodes = 1;
+	tree.rootBoard = board;
+	tree.rootPlayer = player;
+	return 0;
+}
+
+template <class BoardT>
+void MonteCarloSearch<BoardT>::keepSubtree(Tree& tree, const std::uint32_t& newRoot)
+{
+	copyNode(tree.spareNodes[0], tree.nodes[newRoot]);
+	std::uint32_t copied = 1;
+
+	//Copying breadth first keeps every node's children next to each other
+	for (std::uint32_t x = 0; x < copied; x++) {
+		Node& node = tree.spareNodes[x];
+
+		if (node.state == NodeState::EXPANDED) {
+			for (std::uint8_t child = 0; child < node.numChildren; child++) {
+				copyNode(tree.spareNodes[copied + child], tree.nodes[node.firstChild + child]);
+			}
+
+			node.firstChild = copied;
+			copied += node.numChildren;
+		}
+	}
+
+	std::swap(tree.nodes, tree.spareNodes);
+	tree.numNodes = copied;
+}
+
+template <class BoardT>
+void MonteCarloSearch<BoardT>::runPlayout(Tree& tree, Random& random)
+{
+	std::array<std::uint32_t, BoardT::NUM_ROWS * BoardT::NUM_COLS + 1> path;
+	std::uint8_t pathLength = 0;
+
+	BoardT board = tree.rootBoard;
+	std::int8_t player = tree.rootPlayer;
+	std::uint32_t node = 0;
+	std::uint32_t visits = ++tree.nodes[node].visits;
+	path[pathLength++] = node;
+
+	//Follow the most promising children down to a leaf
+	while (tree.nodes[node].state.load(std::memory_order_acquire) == NodeState::EXPANDED) {
+		node = selectChild(tree, node);
+		visits = ++tree.nodes[node].visits;
+		board.addPiece(tree.nodes[node].move, player);
+		player = player == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE;
+		path[pathLength++] = node;
+	}
+
+	//A leaf is only expanded once it has been played from, so moves that are never tried again do not fill the pool
+	if (tree.nodes[node].state.load(std::memory_order_acquire) == NodeState::LEAF && (visits > 1 || node == 0) && expand(tree, node, board, player)) {
+		node = tree.nodes[node].firstChild + random.nextBelow(tree.nodes[node].numChildren);
+		++tree.nodes[node].visits;
+		board.addPiece(tree.nodes[node].move, player);
+		player = player == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE;
+		path[pathLength++] = node;
+	}
+
+	const std::int8_t winner = tree.nodes[node].state.load(std::memory_order_acquire) == NodeState::TERMINAL ? tree.nodes[node].winner : playRandomGame(board, player, random);
+
+	//The root was moved into by the player who is not to move there, and every node below alternates
+	std::int8_t mover = tree.rootPlayer == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE;
+
+	for (std::uint8_t x = 0; x < pathLength; x++) {
+		if (winner == mover || winner == BoardT::NO_PIECE) {
+			tree.nodes[path[x]].score.fetch_add(winner == mover ? 2 : 1, std::memory_order_relaxed);
+		}
+
+		mover = mover == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE;
+	}
+}
+
+template <class BoardT>
+bool MonteCarloSearch<BoardT>::expand(Tree& tree, const std::uint32_t& node, const BoardT& board, const std::int8_t& player)
+{
+	if (tree.numNodes.load(std::memory_order_relaxed) + BoardT::NUM_COLS > tree.capacity) {
+		//The pool is full, so the tree stops growing and playouts start from the leaves
+		return false;
+	}
+
+	NodeState expected = NodeState::LEAF;
+	if (!tree.nodes[node].state.compare_exchange_strong(expected, NodeState::EXPANDING, std::memory_order_acquire)) {
+		return false;
+	}
+
+	std::uint8_t numChildren = 0;
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		numChildren += board.validMove(col);
+	}
+
+	const std::uint32_t firstChild = tree.numNodes.fetch_add(numChildren, std::memory_order_relaxed);
+
+	if (firstChild + numChildren > tree.capacity) {
+		//Another thread took the last of the pool first
+		tree.nodes[node].state.store(NodeState::LEAF, std::memory_order_relaxed);
+		return false;
+	}
+
+	std::uint32_t child = firstChild;
+
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		BoardT childBoard = board;
+		const std::uint8_t square = childBoard.dropPiece(col, player);
+
+		if (square == BoardT::INVALID_SQUARE) {
+			continue;
+		}
+
+		Node& newNode = tree.nodes[child++];
+		copyNode(newNode, Node());
+		newNode.move = col;
+
+		if (childBoard.checkForWinAt(square)) {
+			newNode.state.store(NodeState::TERMINAL, std::memory_order_relaxed);
+			newNode.winner = player;
+		}
+		else if (childBoard.isFull()) {
+			newNode.state.store(NodeState::TERMINAL, std::memory_order_relaxed);
+		}
+	}
+
+	tree.nodes[node].firstChild = firstChild;
+	tree.nodes[node].numChildren = numChildren;
+
+	//Publishes the children to the threads that see the node as EXPANDED
+	tree.nodes[node].state.store(numChildren > 0 ? NodeState::EXPANDED : NodeState::TERMINAL, std::memory_order_release);
+	return true;
+}
+
+template <class BoardT>
+std::uint32_t MonteCarloSearch<BoardT>::selectChild(const Tree& tree, const std::uint32_t& node) const
+{
+	const Node& parent = tree.nodes[node];
+	const double logVisits = std::log(static_cast<double>(parent.visits.load(std::memory_order_relaxed)));
+
+	std::uint32_t best = parent.firstChild;
+	double bestValue = -1;
+
+	for (std::uint32_t child = parent.firstChild; child < parent.firstChild + parent.numChildren; child++) {
+		const std::uint32_t visits = tree.nodes[child].visits.load(std::memory_order_relaxed);
+
+		if (visits == 0) {
+			return child;
+		}
+
+		const double value = tree.nodes[child].score.load(std::memory_order_relaxed) / (2.0 * visits) + EXPLORATION * std::sqrt(logVisits / visits);
+		if (value > bestValue) {
+			best = child;
+			bestValue = value;
+		}
+	}
+
+	return best;
+}
+
+template <class BoardT>
+std::int8_t MonteCarloSearch<BoardT>::playRandomGame(BoardT& board, std::int8_t player, Random& random)
+{
+	while (true) {
+		const std::uint8_t square = board.dropPiece(static_cast<std::uint8_t>(random.nextBelow(BoardT::NUM_COLS)), player);
+
+		if (square == BoardT::INVALID_SQUARE) {
+			//The column is full, so pick another
+			continue;
+		}
+
+		if (board.checkForWinAt(square)) {
+			return player;
+		}
+
+		if (board.isFull()) {
+			return BoardT::NO_PIECE;
+		}
+
+		player = player == BoardT::RED_PIECE ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE;
+	}
+}
+
+template <class BoardT>
+void MonteCarloSearch<BoardT>::copyNode(Node& to, const Node& from)
+{
+	to.visits.store(from.visits.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	to.score.store(from.score.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	to.firstChild = from.firstChild;
+	to.numChildren = from.numChildren;
+	to.move = from.move;
+	to.winner = from.winner;
+	to.state.store(from.state.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+template class MonteCarloSearch<Board4x5>;
+template class MonteCarloSearch<Board5x6>;
+template class MonteCarloSearch<Board6x7>;
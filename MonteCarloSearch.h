@@ -0,0 +1,230 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Board.h"
+#include "Random.h"
+
+/*
+Chooses moves with Monte Carlo tree search (UCT), scoring positions by playing random games from them
+Nothing has to be learned beforehand and the cost does not depend on the number of positions, so it plays on every board size
+Nodes are taken from a pool allocated up front, and the subtree below the moves actually played is kept for the next search
+The search can run on many threads, either sharing one tree or growing a tree each and adding up their results (see Parallelism)
+@param BoardT The type of board the search plays on
+*/
+template <class BoardT>
+class MonteCarloSearch
+{
+public:
+	/*
+	How the threads of a search share the work
+	TREE: Every thread grows the same tree, and a thread passing through a node counts as a lost playout until its result is known (a virtual loss), which steers the other threads elsewhere
+	ROOT: Every thread grows its own tree with an equal share of the pool, and the playouts of each move are added up across the trees at the end
+	*/
+	enum class Parallelism : std::uint8_t { TREE, ROOT };
+
+	//The default size of the node pool (16 bytes per node, and the pool is allocated twice so the tree can be compacted)
+	static constexpr std::uint32_t DEFAULT_MAX_NODES = 1 << 20;
+
+	//The number of playouts per move when no budget is given
+	static constexpr std::uint64_t DEFAULT_PLAYOUTS = 100000;
+
+	//Weighs trying moves that have few playouts against replaying moves that have done well
+	static constexpr double EXPLORATION = 1.4;
+
+	//The number of playouts between checks of the clock
+	static constexpr std::uint64_t CLOCK_CHECK_INTERVAL = 64;
+
+	//Returned as the best move when there is no legal move
+	static constexpr std::uint8_t NO_MOVE = UINT8_MAX;
+
+	//Marks a node without children
+	static constexpr std::uint32_t NO_NODE = UINT32_MAX;
+
+	/*
+	The outcome of a search
+	*/
+	struct Result
+	{
+		//The column with the most playouts
+		std::uint8_t bestMove = NO_MOVE;
+
+		//The share of the best move's playouts that were won, counting draws as half a win
+		double winRate = 0;
+
+		//The playouts made by this search
+		std::uint64_t playouts = 0;
+
+		//The playouts below the root that were kept from earlier searches
+		std::uint64_t reusedPlayouts = 0;
+
+		//The number of nodes in the pool once the search finished
+		std::uint32_t nodesUsed = 0;
+
+		double seconds = 0;
+
+		inline double playoutsPerSecond() const { return seconds > 0 ? playouts / seconds : 0; }
+	};
+
+	/*
+	Initializes the piece the search will be playing with and its budget for each move
+	The search stops at whichever limit is reached first, and uses DEFAULT_PLAYOUTS if neither is given
+	@param pieceToUse The piece that the search will be playing with (either RED_PIECE or YELLOW_PIECE)
+	@param seed The seed for the random games, so single threaded searches can be repeated exactly
+	@param playoutsPerMove The number of playouts to make for each move across every thread, where 0 means no limit
+	@param secondsPerMove The longest a move may be searched for, where 0 means no limit
+	@param numThreads The number of threads to search on
+	@param parallelism How the threads share the work
+	@param maxNodes The size of the node pool, which the tree stops growing at
+	*/
+	MonteCarloSearch(const std::int8_t& pieceToUse, const std::uint64_t& seed, const std::uint64_t& playoutsPerMove, const double& secondsPerMove,
+		const unsigned int& numThreads = 1, const Parallelism& parallelism = Parallelism::TREE, const std::uint32_t& maxNodes = DEFAULT_MAX_NODES);
+
+	/*
+	Finds the best move for this search's piece on the given board, reusing the tree of an earlier search if the board follows on from it
+	@param board The board, on which it must be this search's turn
+	@return Result The best move and the cost of finding it
+	*/
+	Result search(const BoardT& board);
+
+	/*
+	Chooses a move to make based on the board
+	The move will be made on the board directly by the function
+	@param board The current board
+	@return std::uint8_t The column the search placed its piece in
+	*/
+	const std::uint8_t makeMove(BoardT& board);
+
+	/*
+	Returns the outcome of the search behind the last move made
+	@return Result The outcome of the last search
+	*/
+	inline const Result& getLastResult() const { return lastResult; }
+
+	/*
+	Forgets the tree, such as when a new game starts
+	*/
+	void clearTree();
+
+private:
+	//LEAF nodes have not been expanded, and EXPANDING is held by the one thread adding a node's children while the others play from it as a leaf
+	enum class NodeState : std::uint8_t { LEAF, EXPANDING, EXPANDED, TERMINAL };
+
+	/*
+	A position in the tree, reached by playing move from its parent
+	The statistics are atomic so that threads sharing the tree can update them without locks
+	*/
+	struct Node
+	{
+		//Counted on the way down, so a playout in progress counts as a loss until it finishes
+		std::atomic<std::uint32_t> visits{ 0 };
+
+		//Twice the number of playouts won plus the number drawn, for the player who made the move into this node
+		std::atomic<std::uint32_t> score{ 0 };
+
+		//The children are stored next to each other, starting here, and are only valid once the state is EXPANDED
+		std::uint32_t firstChild = NO_NODE;
+		std::uint8_t numChildren = 0;
+
+		std::uint8_t move = NO_MOVE;
+
+		//The winner of a TERMINAL node, or NO_PIECE for a draw
+		std::int8_t winner = BoardT::NO_PIECE;
+
+		std::atomic<NodeState> state{ NodeState::LEAF };
+	};
+
+	/*
+	A tree and the pools its nodes are kept in
+	*/
+	struct Tree
+	{
+		//The node pool, which is never resized once allocated, and the spare pool the kept part of the tree is copied into
+		std::unique_ptr<Node[]> nodes;
+		std::unique_ptr<Node[]> spareNodes;
+		std::uint32_t capacity = 0;
+
+		//May pass the capacity by a few nodes when threads race for the last of the pool
+		std::atomic<std::uint32_t> numNodes{ 0 };
+
+		//The position at the root of the tree and the player to move there, which are only valid if numNodes > 0
+		BoardT rootBoard;
+		std::int8_t rootPlayer = BoardT::NO_PIECE;
+	};
+
+	std::int8_t pieceBeingUsed;
+	std::uint64_t playoutsPerMove;
+	double secondsPerMove;
+	unsigned int numThreads;
+	Parallelism parallelism;
+	std::uint32_t maxNodes;
+
+	//One tree shared by every thread, or one for each thread
+	std::unique_ptr<Tree[]> trees;
+	unsigned int numTrees;
+
+	//Each thread has its own generator, so the random games need no locking
+	std::vector<Random> randoms;
+
+	Result lastResult;
+
+	/*
+	Makes the node for the given board the root, keeping its subtree if it is the root or a child of the root
+	@param tree The tree
+	@param board The board to search from
+	@param player The player to move on the board
+	@return std::uint64_t The number of playouts kept below the new root
+	*/
+	std::uint64_t moveRootTo(Tree& tree, const BoardT& board, const std::int8_t& player);
+
+	/*
+	Copies the subtree below the given node to the start of the spare pool and swaps the pools, which frees every other node
+	Must not be called while the tree is being searched
+	@param tree The tree
+	@param newRoot The node that becomes the root
+	*/
+	void keepSubtree(Tree& tree, const std::uint32_t& newRoot);
+
+	/*
+	Selects a leaf, expands it, plays a random game from it and records the result on every node along the way
+	@param tree The tree, which other threads may be searching at the same time
+	@param random The generator of the calling thread
+	*/
+	void runPlayout(Tree& tree, Random& random);
+
+	/*
+	Adds a child for every legal move to the given node, unless the pool is full or another thread is already expanding it
+	@param tree The tree
+	@param node The node to expand
+	@param board The board at the node
+	@param player The player to move on the board
+	@return bool true if this thread expanded the node
+	*/
+	bool expand(Tree& tree, const std::uint32_t& node, const BoardT& board, const std::int8_t& player);
+
+	/*
+	Returns the child with the best upper confidence bound, or the first child that has not been visited
+	@param tree The tree
+	@param node The node to choose a child of (must be EXPANDED)
+	@return std::uint32_t The chosen child
+	*/
+	std::uint32_t selectChild(const Tree& tree, const std::uint32_t& node) const;
+
+	/*
+	Plays random moves until the game is over
+	@param board The board to play on
+	@param player The player to move on the board
+	@param random The generator of the calling thread
+	@return std::int8_t The winner or NO_PIECE for a draw
+	*/
+	static std::int8_t playRandomGame(BoardT& board, std::int8_t player, Random& random);
+
+	/*
+	Copies a node between pools, which the atomics prevent the assignment operator from doing
+	@param to The node to overwrite
+	@param from The node to copy
+	*/
+	static void copyNode(Node& to, const Node& from);
+};
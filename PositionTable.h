@@ -0,0 +1,373 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+#ifdef _MSC_VER
+#include <xmmintrin.h>
+#endif
+
+/*
+A flat hash table mapping packed position keys to values using open addressing with linear probing
+Values are stored inline next to their keys, so a lookup usually touches a single cache line
+Pointers returned by the table are only valid until the next insertion or erasure
+@param ValueType The type of value stored for each position
+*/
+template <class ValueType>
+class PositionTable
+{
+public:
+	typedef std::uint64_t KeyType;
+
+	//Marks an unused slot, which is why a key of 0 can never be stored
+	static constexpr KeyType EMPTY_KEY = 0;
+
+	//The table grows once it is more than MAX_LOAD_NUMERATOR / MAX_LOAD_DENOMINATOR full
+	static constexpr std::size_t MAX_LOAD_NUMERATOR = 3;
+	static constexpr std::size_t MAX_LOAD_DENOMINATOR = 4;
+
+	static constexpr std::size_t MIN_CAPACITY = 16;
+
+	struct Slot
+	{
+		KeyType key;
+		ValueType value;
+	};
+
+	/*
+	Walks over every used slot of the table
+	*/
+	class Iterator
+	{
+	public:
+		Iterator(Slot* slot, Slot* end) : slot(slot), end(end) { skipEmpty(); }
+
+		inline Slot& operator*() const { return *slot; }
+		inline Slot* operator->() const { return slot; }
+		inline bool operator!=(const Iterator& other) const { return slot != other.slot; }
+		inline Iterator& operator++() { ++slot; skipEmpty(); return *this; }
+
+	private:
+		Slot* slot;
+		Slot* end;
+
+		inline void skipEmpty() {
+			while (slot != end && slot->key == EMPTY_KEY) {
+				++slot;
+			}
+		}
+	};
+
+	/*
+	Walks over every used slot of a constant table
+	*/
+	class ConstIterator
+	{
+	public:
+		ConstIterator(const Slot* slot, const Slot* end) : slot(slot), end(end) { skipEmpty(); }
+
+		inline const Slot& operator*() const { return *slot; }
+		inline const Slot* operator->() const { return slot; }
+		inline bool operator!=(const ConstIterator& other) const { return slot != other.slot; }
+		inline ConstIterator& operator++() { ++slot; skipEmpty(); return *this; }
+
+	private:
+		const Slot* slot;
+		const Slot* end;
+
+		inline void skipEmpty() {
+			while (slot != end && slot->key == EMPTY_KEY) {
+				++slot;
+			}
+		}
+	};
+
+	/*
+	Creates an empty table
+	*/
+	PositionTable() : numElements(0), shift(0), clockHand(0) {}
+
+	/*
+	Returns the value stored for the given key
+	@param key The key to look up (must not be EMPTY_KEY)
+	@return ValueType* A pointer to the value or nullptr if the key is not in the table
+	*/
+	inline ValueType* find(const KeyType& key) {
+		if (slots.empty()) {
+			return nullptr;
+		}
+
+		for (std::size_t index = indexOf(key);; index = (index + 1) & mask()) {
+			if (slots[index].key == key) {
+				return &slots[index].value;
+			}
+
+			if (slots[index].key == EMPTY_KEY) {
+				return nullptr;
+			}
+		}
+	}
+
+	inline const ValueType* find(const KeyType& key) const { return const_cast<PositionTable*>(this)->find(key); }
+
+	/*
+	Starts loading the slot the given key would be found in, so that finding it soon after does not have to wait for memory
+	@param key The key that will be looked up
+	*/
+	inline void prefetch(const KeyType& key) const {
+		if (!slots.empty()) {
+			prefetchAddress(&slots[indexOf(key)]);
+		}
+	}
+
+	/*
+	Starts loading the memory at the given address, which is only a hint to the processor and never faults, even if the memory has been freed
+	@param address The address to load
+	*/
+	static inline void prefetchAddress(const void* address) {
+#ifdef _MSC_VER
+		_mm_prefetch(reinterpret_cast<const char*>(address), _MM_HINT_T0);
+#else
+		__builtin_prefetch(address);
+#endif
+	}
+
+	/*
+	Returns the home slot of the given key in a table with the given shift, so the slot can be found without reading the table
+	@param key The key
+	@param shift The shift of the table (see getShift)
+	@return std::size_t The index of the home slot
+	*/
+	static inline std::size_t homeSlotOf(const KeyType& key, const std::uint8_t& shift) {
+		return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> shift);
+	}
+
+	/*
+	Returns the value stored for the given key
+	@param key The key to look up (must be in the table)
+	@return ValueType& The value
+	*/
+	inline ValueType& at(const KeyType& key) {
+		ValueType* value = find(key);
+
+		if (value == nullptr) {
+			throw std::out_of_range("PositionTable::at: key not found");
+		}
+
+		return *value;
+	}
+
+	/*
+	Inserts the value for the given key if the key is not already in the table
+	@param key The key to insert (must not be EMPTY_KEY)
+	@param value The value to insert
+	@return std::pair<ValueType*, bool> A pointer to the value in the table and whether it was inserted
+	*/
+	inline std::pair<ValueType*, bool> emplace(const KeyType& key, const ValueType& value) {
+		if ((numElements + 1) * MAX_LOAD_DENOMINATOR > slots.size() * MAX_LOAD_NUMERATOR) {
+			rehash(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+		}
+
+		std::size_t index = indexOf(key);
+		while (slots[index].key != EMPTY_KEY) {
+			if (slots[index].key == key) {
+				return std::make_pair(&slots[index].value, false);
+			}
+
+			index = (index + 1) & mask();
+		}
+
+		slots[index].key = key;
+		slots[index].value = value;
+		numElements++;
+		return std::make_pair(&slots[index].value, true);
+	}
+
+	/*
+	Removes the given key from the table
+	Later slots in the same run are shifted back so that lookups never need tombstones
+	@param key The key to remove
+	@return bool true if the key was removed or false if it was not in the table
+	*/
+	inline bool erase(const KeyType& key) {
+		if (slots.empty()) {
+			return false;
+		}
+
+		std::size_t index = indexOf(key);
+		while (slots[index].key != key) {
+			if (slots[index].key == EMPTY_KEY) {
+				return false;
+			}
+
+			index = (index + 1) & mask();
+		}
+
+		eraseAt(index);
+		return true;
+	}
+
+	/*
+	Moves a clock hand around the slots, removing elements until no more than the given number are left
+	Every element the hand passes is offered to the function, which can keep it for now and age it so that it is removed on a later pass (the CLOCK policy)
+	The hand carries on from where it stopped the last time
+	@param maxElements The number of elements to keep
+	@param keep Called with (const KeyType&, ValueType&) for each element the hand passes, returning true to keep the element
+	@return std::size_t The number of elements removed
+	*/
+	template <class Function>
+	std::size_t sweep(const std::size_t& maxElements, Function keep) {
+		std::size_t removed = 0;
+
+		while (numElements > maxElements) {
+			clockHand &= mask();
+			Slot& slot = slots[clockHand];
+
+			if (slot.key != EMPTY_KEY && !keep(slot.key, slot.value)) {
+				//Erasing pulls later elements back into this slot, so the hand stays where it is to look at them
+				eraseAt(clockHand);
+				removed++;
+			}
+			else {
+				clockHand++;
+			}
+		}
+
+		return removed;
+	}
+
+	/*
+	Makes sure the table can hold the given number of elements without growing
+	@param count The number of elements
+	*/
+	void reserve(const std::size_t& count) {
+		std::size_t capacity = MIN_CAPACITY;
+
+		while (count * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+			capacity *= 2;
+		}
+
+		if (capacity > slots.size()) {
+			rehash(capacity);
+		}
+	}
+
+	/*
+	Moves the elements into the smallest array that holds them without growing, such as once many elements have been removed
+	*/
+	void shrinkToFit() {
+		std::size_t capacity = MIN_CAPACITY;
+
+		while (numElements * MAX_LOAD_DENOMINATOR > capacity * MAX_LOAD_NUMERATOR) {
+			capacity *= 2;
+		}
+
+		if (capacity < slots.size()) {
+			rehash(capacity);
+		}
+	}
+
+	/*
+	Removes every element from the table and frees its memory
+	*/
+	void clear() {
+		slots.clear();
+		slots.shrink_to_fit();
+		numElements = 0;
+		shift = 0;
+		clockHand = 0;
+	}
+
+	/*
+	Removes every element but keeps the memory, for tables that are emptied and refilled over and over
+	*/
+	void removeAll() {
+		for (auto& slot : slots) {
+			slot.key = EMPTY_KEY;
+			slot.value = ValueType();
+		}
+
+		numElements = 0;
+	}
+
+	inline std::size_t size() const { return numElements; }
+	inline bool empty() const { return numElements == 0; }
+	inline std::size_t capacity() const { return slots.size(); }
+
+	//The slots move and the shift changes whenever the table grows or shrinks
+	inline const Slot* slotData() const { return slots.data(); }
+	inline std::uint8_t getShift() const { return shift; }
+
+	inline Iterator begin() { return Iterator(slots.data(), slots.data() + slots.size()); }
+	inline Iterator end() { return Iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+	inline ConstIterator begin() const { return ConstIterator(slots.data(), slots.data() + slots.size()); }
+	inline ConstIterator end() const { return ConstIterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+
+private:
+	std::vector<Slot> slots;
+	std::size_t numElements;
+
+	//The number of bits the hash is shifted right by to produce an index (64 - log2 of the capacity)
+	std::uint8_t shift;
+
+	//The next slot sweep will look at
+	std::size_t clockHand;
+
+	inline std::size_t mask() const { return slots.size() - 1; }
+
+	/*
+	Returns the home slot of the given key using Fibonacci hashing, which spreads the structured position keys over the table
+	@param key The key
+	@return std::size_t The index of the home slot
+	*/
+	inline std::size_t indexOf(const KeyType& key) const {
+		return homeSlotOf(key, shift);
+	}
+
+	/*
+	Removes the element in the given slot, shifting back the later slots in its run
+	@param hole The index of the slot (must be used)
+	*/
+	inline void eraseAt(std::size_t hole) {
+		//Pull back every following slot whose home position is not between the hole and itself
+		for (std::size_t index = (hole + 1) & mask(); slots[index].key != EMPTY_KEY; index = (index + 1) & mask()) {
+			const std::size_t home = indexOf(slots[index].key);
+
+			if (((index - home) & mask()) >= ((index - hole) & mask())) {
+				slots[hole] = std::move(slots[index]);
+				hole = index;
+			}
+		}
+
+		slots[hole].key = EMPTY_KEY;
+		slots[hole].value = ValueType();
+		numElements--;
+	}
+
+	/*
+	Moves every element into a new array of slots
+	@param newCapacity The number of slots in the new array (must be a power of 2)
+	*/
+	void rehash(const std::size_t& newCapacity) {
+		std::vector<Slot> oldSlots(newCapacity);
+		oldSlots.swap(slots);
+
+		shift = 64;
+		for (std::size_t capacity = newCapacity; capacity > 1; capacity >>= 1) {
+			shift--;
+		}
+
+		for (auto& slot : oldSlots) {
+			if (slot.key != EMPTY_KEY) {
+				std::size_t index = indexOf(slot.key);
+
+				while (slots[index].key != EMPTY_KEY) {
+					index = (index + 1) & mask();
+				}
+
+				slots[index] = std::move(slot);
+			}
+		}
+	}
+};
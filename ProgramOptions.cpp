@@ -0,0 +1,126 @@
+#include "ProgramOptions.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+ProgramOptions::ProgramOptions()
+	: numThreads(std::max(std::thread::hardware_concurrency(), 1u))
+{}
+
+bool ProgramOptions::parse(const int& argc, char* argv[])
+{
+	try {
+		for (int x = 1; x < argc; x++) {
+			const std::string argument = argv[x];
+			const bool hasValue = x + 1 < argc;
+
+			if (argument == "--board" && hasValue) {
+				boardSize = argv[++x];
+			}
+			else if (argument == "--seed" && hasValue) {
+				seeds.seed(std::stoull(argv[++x]));
+			}
+			else if (argument == "--threads" && hasValue) {
+				numThreads = std::max(std::stoi(argv[++x]), 1);
+			}
+			else if (argument == "--train") {
+				headless = true;
+			}
+			else if (argument == "--benchmark") {
+				benchmark = true;
+			}
+			else if (argument == "--games" && hasValue) {
+				maxGames = std::stoull(argv[++x]);
+			}
+			else if (argument == "--time" && hasValue) {
+				maxSeconds = std::max(std::stod(argv[++x]), 0.0);
+			}
+			else if (argument == "--checkpoint" && hasValue) {
+				checkpointSeconds = std::max(std::stod(argv[++x]), 0.0);
+			}
+			else if (argument == "--journal") {
+				journal = true;
+			}
+			else if (argument == "--compact") {
+				compact = true;
+			}
+			else if (argument == "--tablebase") {
+				buildTablebase = true;
+			}
+			else if (argument == "--solver-time" && hasValue) {
+				solverSeconds = std::max(std::stod(argv[++x]), 0.0);
+			}
+			else if (argument == "--search-playouts" && hasValue) {
+				searchPlayouts = std::stoull(argv[++x]);
+			}
+			else if (argument == "--search-time" && hasValue) {
+				searchSeconds = std::max(std::stod(argv[++x]), 0.0);
+			}
+			else if (argument == "--root-parallel") {
+				rootParallel = true;
+			}
+			else if (argument == "--memory-limit" && hasValue) {
+				memoryLimit = static_cast<std::uint64_t>(std::max(std::stod(argv[++x]), 0.0) * 1024 * 1024);
+			}
+			else if (argument == "--tactics") {
+				tactics = true;
+			}
+			else if (argument == "--batch" && hasValue) {
+				batchSize = static_cast<std::size_t>(std::max(std::stoll(argv[++x]), 1ll));
+			}
+			else if (argument == "--stats" && hasValue) {
+				statsSeconds = std::max(std::stod(argv[++x]), 0.0);
+			}
+			else if (argument == "--stats-file" && hasValue) {
+				statsPath = argv[++x];
+			}
+			else if (argument == "--data1" && hasValue) {
+				data1Path = argv[++x];
+			}
+			else if (argument == "--data2" && hasValue) {
+				data2Path = argv[++x];
+			}
+			else {
+				std::cout << "Unknown option " << argument << "\n";
+				printUsage(argv[0]);
+				return false;
+			}
+		}
+	}
+	catch (const std::logic_error&) {
+		//std::stoi and the others throw if the value is not a number
+		std::cout << "Invalid number in the options\n";
+		printUsage(argv[0]);
+		return false;
+	}
+
+	return true;
+}
+
+void ProgramOptions::printUsage(const std::string& program)
+{
+	std::cout << "Usage: " << program << " [options]\n"
+		<< "  --board 4x5|5x6|6x7   The board size (rows x columns)\n"
+		<< "  --seed number         Seed the AI objects so runs can be repeated\n"
+		<< "  --threads number      The number of threads to train and search on\n"
+		<< "  --train               Train without prompts until a limit is reached or SIGINT/SIGTERM is received\n"
+		<< "  --benchmark           Time the board, the AI and the data files and print the results as JSON\n"
+		<< "  --games number        Stop training after this many games\n"
+		<< "  --time seconds        Stop training after this many seconds\n"
+		<< "  --checkpoint seconds  Save the AI data this often while training\n"
+		<< "  --journal             Save checkpoints by appending the changes since the last save to a journal\n"
+		<< "  --compact             Fold the journals into the data files and exit\n"
+		<< "  --tablebase           Solve every position, save the tablebase for the solver to play from and exit\n"
+		<< "  --solver-time seconds The longest the solver may take per move, or 0 to always solve completely\n"
+		<< "  --search-playouts n   The number of playouts Monte Carlo search makes per move, or 0 for no limit\n"
+		<< "  --search-time seconds The longest Monte Carlo search may take per move, or 0 for no limit\n"
+		<< "  --root-parallel       Give every Monte Carlo search thread its own tree instead of sharing one\n"
+		<< "  --memory-limit MB     Forget the least used boards once the data of either AI reaches this size\n"
+		<< "  --tactics             Make the AI objects take wins, block threats and avoid moves that lose at once\n"
+		<< "  --batch games         The number of games each training thread plays at once, moving in all of them in turn\n"
+		<< "  --stats seconds       Report the speed, win rates and move times of training this often (0 for never)\n"
+		<< "  --stats-file path     Also append the training statistics to this file as one line of JSON per report\n"
+		<< "  --data1 path          The data file of the first AI\n"
+		<< "  --data2 path          The data file of the second AI\n";
+}
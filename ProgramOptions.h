@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Random.h"
+
+/*
+The settings given on the command line
+*/
+struct ProgramOptions
+{
+	//The board size defaults to 4x5, which keeps the original data file names
+	std::string boardSize = "4x5";
+
+	//Seeded from the time unless a seed is given, in which case every game can be replayed
+	Random seeds;
+
+	//The number of threads to train on, which Monte Carlo search also searches on
+	unsigned int numThreads = 1;
+
+	//Train without any prompts until a limit is reached or the program is told to stop (--train)
+	bool headless = false;
+
+	//Time the hot parts of the program and print the results as JSON instead of running normally (--benchmark)
+	bool benchmark = false;
+
+	//The number of games to train for, where 0 means no limit (--games)
+	std::uint64_t maxGames = 0;
+
+	//The number of seconds to train for, where 0 means no limit (--time)
+	double maxSeconds = 0;
+
+	//The number of seconds between saves while training without prompts, where 0 means only saving at the end (--checkpoint)
+	double checkpointSeconds = 0;
+
+	//Save checkpoints by appending the changes since the last save to a journal instead of writing the whole data file (--journal)
+	bool journal = false;
+
+	//Fold the journals into the data files and exit (--compact)
+	bool compact = false;
+
+	//Build the tablebase of every position, save it next to the data files and exit (--tablebase)
+	bool buildTablebase = false;
+
+	//The longest the solver may think about each move, where 0 means solving every position completely (--solver-time)
+	double solverSeconds = 1;
+
+	//The number of playouts Monte Carlo search makes for each move, where 0 means only the time limit applies (--search-playouts)
+	std::uint64_t searchPlayouts = 0;
+
+	//The longest Monte Carlo search may think about each move, where 0 means only the playout limit applies (--search-time)
+	double searchSeconds = 1;
+
+	//Give every Monte Carlo search thread its own tree instead of sharing one (--root-parallel)
+	bool rootParallel = false;
+
+	//The most memory the learned data of each AI may use in bytes, where 0 means no limit (--memory-limit, given in MB)
+	std::uint64_t memoryLimit = 0;
+
+	//Make the AI objects take wins, block threats and avoid moves that lose at once instead of learning to (--tactics)
+	bool tactics = false;
+
+	//The number of games each training thread plays at once, making a move in all of them before the next, where 1 plays one game at a time (--batch)
+	std::size_t batchSize = 1;
+
+	//The number of seconds between the reports of how training is going, where 0 means never reporting (--stats)
+	double statsSeconds = 10;
+
+	//The file the training reports are also appended to as JSON lines, where an empty string means none (--stats-file)
+	std::string statsPath;
+
+	//The data files of both AI objects, which default to files named after the board size when empty (--data1 and --data2)
+	std::string data1Path;
+	std::string data2Path;
+
+	ProgramOptions();
+
+	/*
+	Reads the settings from the command line, printing the usage if they are invalid
+	@param argc The number of arguments
+	@param argv The arguments, starting with the program name
+	@return bool true if every argument was valid or false otherwise
+	*/
+	bool parse(const int& argc, char* argv[]);
+
+	/*
+	Prints every option the program accepts
+	@param program The name the program was run with
+	*/
+	static void printUsage(const std::string& program);
+};
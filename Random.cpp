@@ -1,6 +1,32 @@
 #include "Random.h"
+#include <chrono>
+#include <random>
 
-void Random::init()
+Random::Random()
 {
-	srand(static_cast<unsigned int>(time(NULL)));
-}
\ No newline at end of file
+	//Mix the time into the random device in case the random device is deterministic on this platform
+	std::random_device device;
+	const std::uint64_t time = static_cast<std::uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+
+	seed(time ^ (static_cast<std::uint64_t>(device()) << 32) ^ device());
+}
+
+Random::Random(const std::uint64_t& seed)
+{
+	this->seed(seed);
+}
+
+void Random::seed(const std::uint64_t& seed)
+{
+	//Expand the seed into the full state with splitmix64 so that small or similar seeds still give well mixed states
+	std::uint64_t mixer = seed;
+
+	for (auto& value : state) {
+		mixer += 0x9E3779B97F4A7C15ull;
+
+		std::uint64_t z = mixer;
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		value = z ^ (z >> 31);
+	}
+}
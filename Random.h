@@ -1,22 +1,86 @@
 #pragma once
-#include <time.h>
-#include <cstdlib>
+#include <cstdint>
 
+/*
+A fast random number generator (xoshiro256**) with its own state, so every user can have an independent, reproducible sequence
+*/
 class Random
 {
 public:
 	/*
-	Initializes the seed by time
+	Initializes the seed from the current time and the system's random device
 	*/
-	static void init();
+	Random();
+
+	/*
+	Initializes the seed to the given value so the same sequence can be generated again
+	@param seed The seed to use
+	*/
+	Random(const std::uint64_t& seed);
+
+	/*
+	Restarts the sequence from the given seed
+	@param seed The seed to use
+	*/
+	void seed(const std::uint64_t& seed);
+
+	/*
+	Generates a random 64 bit number
+	@return std::uint64_t The random number
+	*/
+	inline std::uint64_t next() {
+		const std::uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+		const std::uint64_t shifted = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= shifted;
+		state[3] = rotateLeft(state[3], 45);
+
+		return result;
+	}
+
+	/*
+	Generates a random number between 0 and range - 1 without bias
+	Uses a multiply and shift instead of a division, only retrying in the rare case that would favour some results
+	@param range The number of possible results (must be greater than 0)
+	@return std::uint32_t The random number
+	*/
+	inline std::uint32_t nextBelow(const std::uint32_t& range) {
+		std::uint64_t product = static_cast<std::uint64_t>(static_cast<std::uint32_t>(next() >> 32)) * range;
+		std::uint32_t low = static_cast<std::uint32_t>(product);
+
+		if (low < range) {
+			const std::uint32_t threshold = static_cast<std::uint32_t>(-range) % range;
+
+			while (low < threshold) {
+				product = static_cast<std::uint64_t>(static_cast<std::uint32_t>(next() >> 32)) * range;
+				low = static_cast<std::uint32_t>(product);
+			}
+		}
+
+		return static_cast<std::uint32_t>(product >> 32);
+	}
 
 	/*
 	Generates a random integer between min and max
-	max must be greater than min
+	max must be greater than or equal to min
 	@param min The minimum value to be generated
 	@param max The maximum value to be generated
 	@return int The random number
 	*/
-	static inline int nextInt(const int& min, const int& max) { return rand() % (max - min + 1) + min; }
+	inline int nextInt(const int& min, const int& max) { return min + static_cast<int>(nextBelow(static_cast<std::uint32_t>(max - min + 1))); }
+
+	/*
+	Generates a random number between 0 and 1
+	@return double The random number, which can be 0 but never 1
+	*/
+	inline double nextDouble() { return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0); }
+
 private:
-};
\ No newline at end of file
+	std::uint64_t state[4];
+
+	static inline std::uint64_t rotateLeft(const std::uint64_t& value, const int& amount) { return (value << amount) | (value >> (64 - amount)); }
+};
@@ -0,0 +1,556 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include "PositionTable.h"
+
+/*
+A PositionTable split into shards that each have their own lock, so several threads can use the table at once
+Locking only happens while the table is marked as concurrent, which keeps single threaded use as fast as a plain PositionTable
+@param ValueType The type of value stored for each position
+*/
+template <class ValueType>
+class ShardedPositionTable
+{
+public:
+	typedef PositionTable<ValueType> TableType;
+	typedef typename TableType::KeyType KeyType;
+
+	//Must be a power of 2
+	static constexpr std::size_t NUM_SHARDS = 64;
+
+	//A shard that reaches its limit evicts this fraction of its limit at once, so the cost of a sweep is spread over many insertions
+	static constexpr std::size_t EVICTION_DIVISOR = 16;
+
+	/*
+	How long a pass over the shards kept them locked, which is the longest other threads using the table could have been kept waiting
+	Only concurrent tables are timed, since nothing can wait on the others
+	*/
+	struct LockTimes
+	{
+		double totalSeconds = 0;
+
+		//The longest any one shard was kept locked
+		double longestSeconds = 0;
+
+		inline void add(const LockTimes& other) {
+			totalSeconds += other.totalSeconds;
+			longestSeconds = std::max(longestSeconds, other.longestSeconds);
+		}
+	};
+
+	ShardedPositionTable() : concurrent(false), trackChanges(false), memoryLimit(0), maxShardSize(SIZE_MAX) {}
+
+	ShardedPositionTable(const ShardedPositionTable& other) : concurrent(false), trackChanges(false), memoryLimit(0), maxShardSize(SIZE_MAX) { *this = other; }
+
+	ShardedPositionTable& operator=(const ShardedPositionTable& other) {
+		//Only the elements are copied, since the changes recorded by the other table are about its own file and the limit is about its own AI
+		if (this != &other) {
+			for (std::size_t x = 0; x < NUM_SHARDS; x++) {
+				ShardLock otherLock(other.shards[x], other.concurrent);
+				ShardLock lock(shards[x], concurrent);
+				SlotPublisher publisher(shards[x]);
+				shards[x].table = other.shards[x].table;
+			}
+		}
+
+		return *this;
+	}
+
+	/*
+	Turns locking on or off
+	This must only be changed while no other thread is using the table
+	@param isConcurrent true if several threads will use the table at once
+	*/
+	inline void setConcurrent(const bool& isConcurrent) { concurrent = isConcurrent; }
+
+	inline const bool isConcurrent() const { return concurrent; }
+
+	/*
+	Turns recording of changed keys on or off (see markChanged)
+	This must only be changed while no other thread is using the table
+	@param track true to record changed keys
+	*/
+	inline void setTrackChanges(const bool& track) { trackChanges = track; }
+
+	inline const bool isTrackingChanges() const { return trackChanges; }
+
+	/*
+	Records that the given key was inserted, changed or erased, if changes are being tracked
+	Must only be called from within withShard for the same key, while its shard is locked
+	@param key The key that changed
+	*/
+	inline void markChanged(const KeyType& key) {
+		if (trackChanges) {
+			shards[shardOf(key)].changedKeys.emplace(key, 0);
+		}
+	}
+
+	/*
+	Calls the given function for every key that has changed since the changes were last taken, then forgets those changes
+	One shard is locked at a time, for as long as the function takes with its changes
+	@param function Called with (const KeyType&, const ValueType*), where the value is nullptr if the key has been erased
+	@return LockTimes How long the shards were kept locked
+	*/
+	template <class Function>
+	LockTimes takeChanges(Function function) {
+		LockTimes lockTimes;
+
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			const auto start = startLockTimer();
+
+			for (auto& slot : shard.changedKeys) {
+				function(slot.key, static_cast<const TableType&>(shard.table).find(slot.key));
+			}
+
+			shard.changedKeys.removeAll();
+			stopLockTimer(start, lockTimes);
+		}
+
+		return lockTimes;
+	}
+
+	/*
+	Forgets every recorded change, such as once the whole table has been saved
+	*/
+	void clearChanges() {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			shard.changedKeys.removeAll();
+		}
+	}
+
+	/*
+	Returns the number of keys that have changed since the changes were last taken
+	@return std::size_t The number of changed keys
+	*/
+	std::size_t numChanges() const {
+		std::size_t total = 0;
+
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			total += shard.changedKeys.size();
+		}
+
+		return total;
+	}
+
+	/*
+	Limits the memory the table's slots may use, which insertions keep to by evicting elements (see makeRoomFor)
+	Each shard gets an equal share, and since a shard's slots double as it grows, a shard stops at the largest size that fits within its share
+	This must only be changed while no other thread is using the table, and elements already beyond the limit stay until trimToLimit is called
+	@param bytes The most memory the slots may use, or 0 for no limit
+	*/
+	void setMemoryLimit(const std::size_t& bytes) {
+		memoryLimit = bytes;
+		maxShardSize = SIZE_MAX;
+
+		if (bytes > 0) {
+			//A shard can fill its slots up to the table's maximum load before it has to grow
+			std::size_t shardCapacity = TableType::MIN_CAPACITY;
+			while (shardCapacity * 2 * sizeof(typename TableType::Slot) <= bytes / NUM_SHARDS) {
+				shardCapacity *= 2;
+			}
+
+			maxShardSize = shardCapacity * TableType::MAX_LOAD_NUMERATOR / TableType::MAX_LOAD_DENOMINATOR;
+		}
+	}
+
+	inline const std::size_t getMemoryLimit() const { return memoryLimit; }
+
+	inline const bool isLimited() const { return memoryLimit > 0; }
+
+	/*
+	Evicts elements from the shard that holds the given key if the shard is full, so the key can be inserted without passing the memory limit
+	Evicted elements are recorded as changed so that a journal forgets them too
+	Must only be called from within withShard for the same key, while its shard is locked
+	@param key The key about to be inserted
+	@param keep Called with (const KeyType&, ValueType&) for each element the clock hand passes, returning true to keep the element (see PositionTable::sweep)
+	@return std::size_t The number of elements evicted
+	*/
+	template <class Function>
+	inline std::size_t makeRoomFor(const KeyType& key, Function keep) {
+		Shard& shard = shards[shardOf(key)];
+
+		if (shard.table.size() < maxShardSize) {
+			return 0;
+		}
+
+		return evict(shard, maxShardSize - std::max<std::size_t>(maxShardSize / EVICTION_DIVISOR, 1), keep);
+	}
+
+	/*
+	Evicts elements from every shard until each is within the memory limit, then frees the memory of the evicted elements
+	Used once elements have been added without makeRoomFor, such as by reading a data file
+	@param keep Called with (const KeyType&, ValueType&) for each element the clock hand passes, returning true to keep the element (see PositionTable::sweep)
+	*/
+	template <class Function>
+	void trimToLimit(Function keep) {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			SlotPublisher publisher(shard);
+
+			if (shard.table.size() > maxShardSize) {
+				evict(shard, maxShardSize, keep);
+			}
+
+			shard.table.shrinkToFit();
+		}
+	}
+
+	/*
+	Returns the number of elements evicted to keep to the memory limit since the table was created
+	@return std::uint64_t The number of evicted elements
+	*/
+	std::uint64_t numEvictions() const {
+		std::uint64_t total = 0;
+
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			total += shard.evictions;
+		}
+
+		return total;
+	}
+
+	/*
+	Returns the memory used by the slots of every shard, which is what the memory limit applies to
+	@return std::size_t The number of bytes
+	*/
+	inline std::size_t memoryUsage() const { return capacity() * sizeof(typename TableType::Slot); }
+
+	/*
+	Calls the given function with the shard that holds the given key while that shard is locked
+	Pointers into the shard must not be kept after the function returns
+	@param key The key that will be used within the function
+	@param function Called with the TableType& of the shard
+	@return The value returned by the function
+	*/
+	template <class Function>
+	inline auto withShard(const KeyType& key, Function function) -> decltype(function(std::declval<TableType&>())) {
+		Shard& shard = shards[shardOf(key)];
+		ShardLock lock(shard, concurrent);
+		SlotPublisher publisher(shard);
+		return function(shard.table);
+	}
+
+	/*
+	Copies the value stored for the given key
+	@param key The key to look up
+	@param value Set to the stored value if the key is found
+	@return bool true if the key was found or false otherwise
+	*/
+	inline bool find(const KeyType& key, ValueType& value) const {
+		const Shard& shard = shards[shardOf(key)];
+		ShardLock lock(shard, concurrent);
+
+		const ValueType* stored = shard.table.find(key);
+		if (stored == nullptr) {
+			return false;
+		}
+
+		value = *stored;
+		return true;
+	}
+
+	/*
+	Starts loading the slot the given key would be found in (see PositionTable::prefetch)
+	The shard is not locked, since the slots it publishes are enough to find the slot, and a slot of a table that has just grown is only a wasted hint
+	@param key The key that will be looked up
+	*/
+	inline void prefetch(const KeyType& key) const {
+		const Shard& shard = shards[shardOf(key)];
+		const std::uintptr_t address = shard.slotAddress.load(std::memory_order_relaxed);
+
+		if (address != 0) {
+			//The address is worked out as an integer, since the slots may have been freed by the time it is prefetched
+			const std::size_t slot = TableType::homeSlotOf(key, shard.slotShift.load(std::memory_order_relaxed));
+			TableType::prefetchAddress(reinterpret_cast<const void*>(address + slot * sizeof(typename TableType::Slot)));
+		}
+	}
+
+	/*
+	Inserts the value for the given key if the key is not already in the table
+	@param key The key to insert (must not be EMPTY_KEY)
+	@param value The value to insert
+	@return bool true if the value was inserted or false if the key was already in the table
+	*/
+	inline bool emplace(const KeyType& key, const ValueType& value) {
+		return withShard(key, [&](TableType& table) { return table.emplace(key, value).second; });
+	}
+
+	/*
+	Removes the given key from the table
+	@param key The key to remove
+	@return bool true if the key was removed or false if it was not in the table
+	*/
+	inline bool erase(const KeyType& key) {
+		return withShard(key, [&](TableType& table) { return table.erase(key); });
+	}
+
+	/*
+	Calls the given function with the key and value of every element, locking one shard at a time
+	@param function Called with (const KeyType&, const ValueType&) for every element
+	*/
+	template <class Function>
+	void forEach(Function function) const {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+
+			for (auto& slot : shard.table) {
+				function(slot.key, slot.value);
+			}
+		}
+	}
+
+	/*
+	Calls the given function with the table of every shard, locking one shard at a time
+	@param function Called with the const TableType& of each shard
+	*/
+	template <class Function>
+	void forEachShard(Function function) const {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			function(static_cast<const TableType&>(shard.table));
+		}
+	}
+
+	/*
+	Calls the given function with every shard's elements as they were when that shard was copied, forgetting the changes the copy holds
+	Each shard is only locked while it is copied, so other threads keep using the table while the copies are used, such as to save it
+	The shards are copied one after another, so together they are not the table as it was at any one moment, although each shard is
+	The shards are used in place when the table is not concurrent, since nothing else can change them
+	@param function Called with the const TableType& of each shard's elements
+	@return LockTimes How long the shards were kept locked while they were copied
+	*/
+	template <class Function>
+	LockTimes forEachShardSnapshot(Function function) {
+		LockTimes lockTimes;
+		TableType copy;
+
+		for (auto& shard : shards) {
+			if (!concurrent) {
+				function(static_cast<const TableType&>(shard.table));
+				shard.changedKeys.removeAll();
+				continue;
+			}
+
+			{
+				ShardLock lock(shard, concurrent);
+				const auto start = startLockTimer();
+
+				copy = shard.table;
+				shard.changedKeys.removeAll();
+				stopLockTimer(start, lockTimes);
+			}
+
+			function(static_cast<const TableType&>(copy));
+		}
+
+		return lockTimes;
+	}
+
+	/*
+	Makes sure the table can hold the given number of elements without growing
+	@param count The number of elements
+	*/
+	void reserve(const std::size_t& count) {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			SlotPublisher publisher(shard);
+			shard.table.reserve(count / NUM_SHARDS + 1);
+		}
+	}
+
+	/*
+	Removes every element from the table and frees its memory
+	*/
+	void clear() {
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			SlotPublisher publisher(shard);
+			shard.table.clear();
+			shard.changedKeys.clear();
+		}
+	}
+
+	/*
+	Returns the number of elements in the table
+	@return std::size_t The number of elements
+	*/
+	std::size_t size() const {
+		std::size_t total = 0;
+
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			total += shard.table.size();
+		}
+
+		return total;
+	}
+
+	/*
+	Returns the number of slots allocated across every shard
+	@return std::size_t The number of slots
+	*/
+	std::size_t capacity() const {
+		std::size_t total = 0;
+
+		for (auto& shard : shards) {
+			ShardLock lock(shard, concurrent);
+			total += shard.table.capacity();
+		}
+
+		return total;
+	}
+
+	/*
+	Returns the shard that holds the given key
+	A different multiplier to the one PositionTable uses keeps the shards from all filling the same part of their tables
+	@param key The key
+	@return std::size_t The index of the shard
+	*/
+	static inline std::size_t shardOf(const KeyType& key) {
+		return static_cast<std::size_t>((key * 0xD6E8FEB86659FD93ull) >> 58) & (NUM_SHARDS - 1);
+	}
+
+private:
+	/*
+	A table and the spin lock guarding it, kept on its own cache line so threads working on different shards do not slow each other down
+	*/
+	struct alignas(64) Shard
+	{
+		mutable std::atomic<bool> locked;
+		TableType table;
+
+		//The keys of the shard that have changed while changes are being tracked
+		PositionTable<std::uint8_t> changedKeys;
+
+		//The number of elements evicted from this shard
+		std::uint64_t evictions;
+
+		//Where the table's slots are and the shift that maps keys to them, published while the shard is locked so prefetch can find a slot without locking
+		//The two are stored separately, so prefetch may see one from before the table grew and one from after, which only wastes the hint
+		std::atomic<std::uintptr_t> slotAddress;
+		std::atomic<std::uint8_t> slotShift;
+
+		Shard() : locked(false), evictions(0), slotAddress(0), slotShift(0) {}
+	};
+
+	/*
+	Holds the lock of a shard for as long as it exists, if the table is concurrent
+	*/
+	class ShardLock
+	{
+	public:
+		ShardLock(const Shard& shard, const bool& concurrent) : shard(concurrent ? &shard : nullptr) {
+			if (this->shard != nullptr) {
+				while (this->shard->locked.exchange(true, std::memory_order_acquire)) {
+					//Wait without writing to the cache line until the lock looks free
+					while (this->shard->locked.load(std::memory_order_relaxed)) {
+						std::this_thread::yield();
+					}
+				}
+			}
+		}
+
+		~ShardLock() {
+			if (shard != nullptr) {
+				shard->locked.store(false, std::memory_order_release);
+			}
+		}
+
+		ShardLock(const ShardLock&) = delete;
+		ShardLock& operator=(const ShardLock&) = delete;
+
+	private:
+		const Shard* shard;
+	};
+
+	/*
+	Publishes where the slots of a shard are once the shard has been changed, while it is still locked
+	*/
+	class SlotPublisher
+	{
+	public:
+		SlotPublisher(Shard& shard) : shard(shard) {}
+
+		~SlotPublisher() {
+			const std::uintptr_t address = shard.table.capacity() == 0 ? 0 : reinterpret_cast<std::uintptr_t>(shard.table.slotData());
+
+			//Nearly every change leaves the slots where they were, so the cache line is only written when they move
+			if (shard.slotAddress.load(std::memory_order_relaxed) != address || shard.slotShift.load(std::memory_order_relaxed) != shard.table.getShift()) {
+				shard.slotShift.store(shard.table.getShift(), std::memory_order_relaxed);
+				shard.slotAddress.store(address, std::memory_order_relaxed);
+			}
+		}
+
+		SlotPublisher(const SlotPublisher&) = delete;
+		SlotPublisher& operator=(const SlotPublisher&) = delete;
+
+	private:
+		Shard& shard;
+	};
+
+	static_assert((NUM_SHARDS & (NUM_SHARDS - 1)) == 0, "NUM_SHARDS must be a power of 2");
+
+	std::array<Shard, NUM_SHARDS> shards;
+	bool concurrent;
+	bool trackChanges;
+
+	std::size_t memoryLimit;
+
+	//The most elements a shard may hold while keeping to the memory limit
+	std::size_t maxShardSize;
+
+	/*
+	Reads the clock once a shard has been locked, if the table is concurrent
+	@return std::chrono::steady_clock::time_point The time, or the default time if the table is not concurrent
+	*/
+	inline std::chrono::steady_clock::time_point startLockTimer() const {
+		return concurrent ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+	}
+
+	/*
+	Adds the time since startLockTimer to the given lock times just before the shard is unlocked, if the table is concurrent
+	@param start The time returned by startLockTimer
+	@param lockTimes The lock times to add to
+	*/
+	inline void stopLockTimer(const std::chrono::steady_clock::time_point& start, LockTimes& lockTimes) const {
+		if (concurrent) {
+			const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			lockTimes.totalSeconds += seconds;
+			lockTimes.longestSeconds = std::max(lockTimes.longestSeconds, seconds);
+		}
+	}
+
+	/*
+	Sweeps the given shard down to the given number of elements, which must be locked by the caller
+	@param shard The shard
+	@param maxElements The number of elements to keep
+	@param keep Decides which elements to keep (see PositionTable::sweep)
+	@return std::size_t The number of elements evicted
+	*/
+	template <class Function>
+	std::size_t evict(Shard& shard, const std::size_t& maxElements, Function& keep) {
+		const std::size_t evicted = shard.table.sweep(maxElements, [&](const KeyType& key, ValueType& value) {
+			if (keep(key, value)) {
+				return true;
+			}
+
+			if (trackChanges) {
+				shard.changedKeys.emplace(key, 0);
+			}
+
+			return false;
+		});
+
+		shard.evictions += evicted;
+		return evicted;
+	}
+};
@@ -0,0 +1,204 @@
+#include "Solver.h"
+#include <algorithm>
+#include <cstdlib>
+
+template <class BoardT>
+constexpr std::array<std::uint8_t, BoardT::NUM_COLS> Solver<BoardT>::MOVE_ORDER;
+
+template <class BoardT>
+Solver<BoardT>::Solver(const std::int8_t& pieceToUse, const double& secondsPerMove, const std::uint8_t& tableBits)
+	: pieceBeingUsed(pieceToUse), secondsPerMove(secondsPerMove), table(static_cast<std::size_t>(1) << tableBits), tableBits(tableBits),
+	positionsSearched(0), timed(false), aborted(false)
+{}
+
+template <class BoardT>
+typename Solver<BoardT>::Result Solver<BoardT>::solve(const BoardT& board)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	const BitboardType current = board.getPieceMask(pieceBeingUsed);
+	const BitboardType occupied = board.getOccupiedMask();
+	const std::uint8_t numPieces = board.getNumPieces();
+
+	positionsSearched = 0;
+	timed = false;
+	deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(secondsPerMove));
+	aborted = false;
+
+	Result result;
+
+	const std::uint8_t entry = tablebase ? tablebase->lookup(board, pieceBeingUsed) : 0;
+	if (Tablebase<BoardT>::outcomeOf(entry) != Tablebase<BoardT>::Outcome::UNKNOWN) {
+		//The game ends with the piece numPieces + distance, which gives the score of a win or loss
+		const std::uint8_t distance = Tablebase<BoardT>::distanceOf(entry);
+		const int winScore = (NUM_CELLS + 2 - (numPieces + distance)) / 2;
+
+		result.bestMove = tablebase->bestMove(board, pieceBeingUsed);
+		result.score = Tablebase<BoardT>::outcomeOf(entry) == Tablebase<BoardT>::Outcome::WIN ? winScore
+			: (Tablebase<BoardT>::outcomeOf(entry) == Tablebase<BoardT>::Outcome::LOSS ? -winScore : 0);
+		result.depth = distance;
+		result.exact = true;
+		result.positionsSearched = 1;
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return result;
+	}
+
+	//Searching one ply deeper each time means a move is ready whenever time runs out, and the table orders each search from the one before
+	for (std::uint8_t depth = 1; depth <= NUM_CELLS - numPieces; depth++) {
+		std::uint8_t bestMove = NO_MOVE;
+		const int score = negamax(current, occupied, numPieces, depth, -MAX_SCORE, MAX_SCORE, bestMove);
+
+		if (aborted) {
+			break;
+		}
+
+		result.bestMove = bestMove;
+		result.score = score;
+		result.depth = depth;
+
+		//Time only runs out once the first search has finished, so there is always a move to make
+		timed = secondsPerMove > 0;
+
+		//A win or loss is real however it was found, but positions kept in the table from deeper searches can show a slow win before a quicker one is in reach,
+		//so a score is only final once the search reaches the last move that could end the game with that score
+		const int lastPiece = NUM_CELLS + 2 - 2 * std::abs(score);
+		if (depth == NUM_CELLS - numPieces || (score != 0 && lastPiece - numPieces <= depth + 1)) {
+			result.exact = true;
+			break;
+		}
+	}
+
+	result.positionsSearched = positionsSearched;
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+template <class BoardT>
+const std::uint8_t Solver<BoardT>::makeMove(BoardT& board)
+{
+	lastResult = solve(board);
+	board.addPiece(lastResult.bestMove, pieceBeingUsed);
+	return lastResult.bestMove;
+}
+
+template <class BoardT>
+void Solver<BoardT>::clearTable()
+{
+	std::fill(table.begin(), table.end(), Entry());
+}
+
+template <class BoardT>
+int Solver<BoardT>::negamax(const BitboardType& current, const BitboardType& occupied, const std::uint8_t& numPieces, const std::uint8_t& depth, int alpha, int beta, std::uint8_t& bestMove)
+{
+	positionsSearched++;
+
+	if (timed && (positionsSearched & (CLOCK_CHECK_INTERVAL - 1)) == 0 && std::chrono::steady_clock::now() > deadline) {
+		aborted = true;
+	}
+
+	if (aborted) {
+		return 0;
+	}
+
+	//Adding the bottom of every column to the occupied spaces carries into the lowest open space of each column
+	const BitboardType playable = (occupied + BoardT::BOTTOM_MASK) & BoardT::BOARD_MASK;
+
+	for (std::uint8_t col : MOVE_ORDER) {
+		const BitboardType move = playable & BoardT::COL_MASKS[col];
+
+		if (move && BoardT::isWinningMask(current | move)) {
+			bestMove = col;
+			return (NUM_CELLS + 1 - numPieces) / 2;
+		}
+	}
+
+	if (numPieces >= NUM_CELLS - 1) {
+		//The last move of the game cannot win, so the game is a draw
+		for (std::uint8_t col : MOVE_ORDER) {
+			if (playable & BoardT::COL_MASKS[col]) {
+				bestMove = col;
+			}
+		}
+
+		return 0;
+	}
+
+	if (depth == 0) {
+		//Nothing is known about positions beyond the search
+		return 0;
+	}
+
+	//The player to move cannot win with this move, so the best they can do is win with their next one
+	const int maxScore = (NUM_CELLS - 1 - numPieces) / 2;
+	if (beta > maxScore) {
+		beta = maxScore;
+
+		if (alpha >= beta) {
+			return beta;
+		}
+	}
+
+	const KeyType key = current + occupied + BoardT::BOTTOM_MASK;
+	Entry& entry = table[indexOf(key)];
+	std::uint8_t tableMove = NO_MOVE;
+
+	if (entry.key == key) {
+		tableMove = entry.bestMove;
+
+		if (entry.depth >= depth) {
+			const int score = entry.score;
+
+			if (entry.bound == Bound::EXACT || (entry.bound == Bound::LOWER && score >= beta) || (entry.bound == Bound::UPPER && score <= alpha)) {
+				bestMove = entry.bestMove;
+				return score;
+			}
+		}
+	}
+
+	const int originalAlpha = alpha;
+	int bestScore = -MAX_SCORE - 1;
+	std::uint8_t localBestMove = NO_MOVE;
+
+	//The best move of an earlier search is tried first, then the rest from the centre outwards
+	for (std::uint8_t x = 0; x <= BoardT::NUM_COLS; x++) {
+		const std::uint8_t col = x == 0 ? tableMove : MOVE_ORDER[x - 1];
+
+		if (col == NO_MOVE || (x > 0 && col == tableMove) || !(playable & BoardT::COL_MASKS[col])) {
+			continue;
+		}
+
+		std::uint8_t replyMove = NO_MOVE;
+		const int score = -negamax(current ^ occupied, occupied | (playable & BoardT::COL_MASKS[col]), numPieces + 1, depth - 1, -beta, -alpha, replyMove);
+
+		if (aborted) {
+			return 0;
+		}
+
+		if (score > bestScore) {
+			bestScore = score;
+			localBestMove = col;
+		}
+
+		alpha = std::max(alpha, score);
+		if (alpha >= beta) {
+			break;
+		}
+	}
+
+	bestMove = localBestMove;
+
+	//A position keeps the result of its deepest search, but any other position that lands on the same entry replaces it
+	if (entry.key != key || entry.depth <= depth) {
+		entry.key = key;
+		entry.score = static_cast<std::int8_t>(bestScore);
+		entry.depth = depth;
+		entry.bound = bestScore <= originalAlpha ? Bound::UPPER : (bestScore >= beta ? Bound::LOWER : Bound::EXACT);
+		entry.bestMove = localBestMove;
+	}
+
+	return bestScore;
+}
+
+template class Solver<Board4x5>;
+template class Solver<Board5x6>;
+template class Solver<Board6x7>;
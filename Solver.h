@@ -0,0 +1,168 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Board.h"
+#include "Tablebase.h"
+
+/*
+Plays perfectly (or as well as it can within a time limit) by searching the game tree with alpha-beta negamax
+Positions that have been searched are kept in a fixed-size transposition table, which is kept between moves and games
+The search deepens one ply at a time, so it always has the best move of the deepest search that finished when time runs out
+Positions held by a tablebase are answered from it without searching
+@param BoardT The type of board the solver plays on
+*/
+template <class BoardT>
+class Solver
+{
+public:
+	typedef typename BoardT::KeyType KeyType;
+	typedef typename BoardT::BitboardType BitboardType;
+
+	//The number of spaces on the board
+	static constexpr std::uint8_t NUM_CELLS = BoardT::NUM_ROWS * BoardT::NUM_COLS;
+
+	//Scores are positive if the player to move can force a win, negative if they will lose and 0 for a draw (or a position not searched deep enough to tell)
+	//A win with n pieces on the board after the winning move scores (NUM_CELLS + 2 - n) / 2, so faster wins score higher
+	static constexpr int MAX_SCORE = (NUM_CELLS + 1) / 2;
+
+	//The default number of entries in the transposition table, as a power of 2 (16 bytes each)
+	static constexpr std::uint8_t DEFAULT_TABLE_BITS = 21;
+
+	//The number of positions searched between checks of the clock
+	static constexpr std::uint64_t CLOCK_CHECK_INTERVAL = 4096;
+
+	//Returned as the best move when there is no legal move
+	static constexpr std::uint8_t NO_MOVE = UINT8_MAX;
+
+	/*
+	The outcome of a search
+	*/
+	struct Result
+	{
+		//The column to play
+		std::uint8_t bestMove = NO_MOVE;
+
+		//The score of the position for the player to move (see MAX_SCORE)
+		int score = 0;
+
+		//The number of plies of the deepest search that finished
+		std::uint8_t depth = 0;
+
+		//true if the score is the score of perfect play rather than the best that could be found in time
+		bool exact = false;
+
+		std::uint64_t positionsSearched = 0;
+		double seconds = 0;
+
+		inline double positionsPerSecond() const { return seconds > 0 ? positionsSearched / seconds : 0; }
+	};
+
+	/*
+	Initializes the piece the solver will be playing with
+	@param pieceToUse The piece that the solver will be playing with (either RED_PIECE or YELLOW_PIECE)
+	@param secondsPerMove The longest a move may be searched for, where 0 means searching until the game is solved
+	@param tableBits The transposition table holds 2 ^ tableBits positions
+	*/
+	Solver(const std::int8_t& pieceToUse, const double& secondsPerMove = 0, const std::uint8_t& tableBits = DEFAULT_TABLE_BITS);
+
+	/*
+	Finds the best move for this solver's piece on the given board
+	@param board The board, on which it must be this solver's turn
+	@return Result The best move and what is known about the position
+	*/
+	Result solve(const BoardT& board);
+
+	/*
+	Chooses a move to make based on the board
+	The move will be made on the board directly by the function
+	@param board The current board
+	@return std::uint8_t The column the solver placed its piece in
+	*/
+	const std::uint8_t makeMove(BoardT& board);
+
+	/*
+	Returns the outcome of the search behind the last move made
+	@return Result The outcome of the last search
+	*/
+	inline const Result& getLastResult() const { return lastResult; }
+
+	/*
+	Forgets every searched position
+	*/
+	void clearTable();
+
+	/*
+	Answers every position held by the given tablebase from it instead of searching
+	@param tablebase The tablebase, or nullptr to always search
+	*/
+	inline void useTablebase(const std::shared_ptr<const Tablebase<BoardT>>& tablebase) { this->tablebase = tablebase; }
+
+private:
+	enum class Bound : std::uint8_t { NONE, EXACT, LOWER, UPPER };
+
+	/*
+	A searched position, indexed by a hash of its key
+	*/
+	struct Entry
+	{
+		KeyType key = 0;
+		std::int8_t score = 0;
+
+		//The number of plies the position was searched to, where NUM_CELLS means it was searched to the end of the game
+		std::uint8_t depth = 0;
+
+		Bound bound = Bound::NONE;
+		std::uint8_t bestMove = NO_MOVE;
+	};
+
+	//The columns in the order they are searched, from the centre outwards, since central pieces are part of the most lines
+	static constexpr std::array<std::uint8_t, BoardT::NUM_COLS> MOVE_ORDER = [] {
+		std::array<std::uint8_t, BoardT::NUM_COLS> order{};
+
+		for (std::uint8_t x = 0; x < BoardT::NUM_COLS; x++) {
+			//Alternates either side of the centre: 0, -1, +1, -2, +2... (or the mirror of that for an even number of columns)
+			order[x] = static_cast<std::uint8_t>(BoardT::NUM_COLS / 2 + (1 - 2 * (x % 2)) * (x + 1) / 2);
+		}
+
+		return order;
+	}();
+
+	std::int8_t pieceBeingUsed;
+	double secondsPerMove;
+
+	std::vector<Entry> table;
+	std::uint8_t tableBits;
+
+	Result lastResult;
+
+	std::shared_ptr<const Tablebase<BoardT>> tablebase;
+
+	//State of the search in progress
+	std::uint64_t positionsSearched;
+	std::chrono::steady_clock::time_point deadline;
+	bool timed;
+	bool aborted;
+
+	/*
+	Returns the score of the given position searched to the given depth
+	@param current The pieces of the player to move
+	@param occupied Every piece on the board
+	@param numPieces The number of pieces on the board
+	@param depth The number of plies left to search
+	@param alpha The score the player to move is already sure of
+	@param beta The score the opponent is already sure of
+	@param bestMove Set to the best move found
+	@return int The score, which is only exact if it lies between alpha and beta
+	*/
+	int negamax(const BitboardType& current, const BitboardType& occupied, const std::uint8_t& numPieces, const std::uint8_t& depth, int alpha, int beta, std::uint8_t& bestMove);
+
+	/*
+	Returns the index of the table entry for the given key
+	@param key The key
+	@return std::size_t The index of the entry
+	*/
+	inline std::size_t indexOf(const KeyType& key) const { return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - tableBits)); }
+};
@@ -0,0 +1,268 @@
+#include "Tablebase.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include "AtomicFile.h"
+#include "ByteOrder.h"
+
+template <class BoardT>
+constexpr std::array<std::uint64_t, BoardT::NUM_COLS> Tablebase<BoardT>::COLUMN_PLACES;
+
+template <class BoardT>
+constexpr std::array<char, 4> Tablebase<BoardT>::MAGIC;
+
+template <class BoardT>
+Tablebase<BoardT>::Tablebase()
+	: numPositions(0)
+{}
+
+template <class BoardT>
+bool Tablebase<BoardT>::generate(const unsigned int& numThreads)
+{
+	if (NUM_ENTRIES > MAX_ENTRIES) {
+		return false;
+	}
+
+	entries.assign(static_cast<std::size_t>(NUM_ENTRIES), 0);
+	numPositions = 0;
+
+	//Group every combination of column heights by the number of pieces it holds
+	std::vector<std::vector<std::array<std::uint8_t, BoardT::NUM_COLS>>> heightsByPieces(NUM_CELLS + 1);
+	std::array<std::uint8_t, BoardT::NUM_COLS> heights{};
+
+	while (true) {
+		std::uint8_t numPieces = 0;
+		for (std::uint8_t height : heights) {
+			numPieces += height;
+		}
+
+		heightsByPieces[numPieces].push_back(heights);
+
+		//Count up through every combination, with each column as a digit from 0 to NUM_ROWS
+		std::uint8_t col = 0;
+		while (col < BoardT::NUM_COLS && heights[col] == BoardT::NUM_ROWS) {
+			heights[col++] = 0;
+		}
+
+		if (col == BoardT::NUM_COLS) {
+			break;
+		}
+
+		heights[col]++;
+	}
+
+	//Full boards come first since they do not depend on anything, then every earlier layer depends only on the one solved before it
+	for (std::uint8_t numPieces = NUM_CELLS + 1; numPieces-- > 0;) {
+		const std::vector<std::array<std::uint8_t, BoardT::NUM_COLS>>& layer = heightsByPieces[numPieces];
+		std::atomic<std::size_t> nextHeights(0);
+		std::atomic<std::uint64_t> layerPositions(0);
+
+		//Every position is written by exactly one thread and only positions from the layer before are read, so no locking is needed
+		auto solveSomeHeights = [&]() {
+			std::uint64_t solved = 0;
+
+			for (std::size_t x = nextHeights++; x < layer.size(); x = nextHeights++) {
+				solved += solvePositions(layer[x]);
+			}
+
+			layerPositions += solved;
+		};
+
+		const std::size_t threadsToUse = std::min<std::size_t>(std::max(numThreads, 1u), std::max<std::size_t>(layer.size(), 1));
+		std::vector<std::thread> threads;
+
+		for (std::size_t x = 1; x < threadsToUse; x++) {
+			threads.emplace_back(solveSomeHeights);
+		}
+
+		solveSomeHeights();
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+
+		numPositions += layerPositions;
+	}
+
+	return true;
+}
+
+template <class BoardT>
+std::uint64_t Tablebase<BoardT>::solvePositions(const std::array<std::uint8_t, BoardT::NUM_COLS>& heights)
+{
+	//The squares holding pieces, in order, which the colourings below are spread over
+	std::array<std::uint8_t, NUM_CELLS> squares;
+	std::uint8_t numPieces = 0;
+	BitboardType occupied = 0;
+
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		for (std::uint8_t height = 0; height < heights[col]; height++) {
+			squares[numPieces++] = col * BoardT::COL_HEIGHT + height;
+		}
+
+		occupied |= (BoardT::COL_MASKS[col] & BoardT::BOTTOM_MASK) * ((static_cast<BitboardType>(1) << heights[col]) - 1);
+	}
+
+	//Yellow moves first, so red has played one fewer piece than yellow whenever the number of pieces is odd
+	const std::uint8_t numRed = numPieces / 2;
+	const int mover = playerToMove(numPieces);
+	const BitboardType playable = (occupied + BoardT::BOTTOM_MASK) & BoardT::BOARD_MASK;
+
+	std::uint64_t solved = 0;
+	const std::uint64_t lastColouring = static_cast<std::uint64_t>(1) << numPieces;
+
+	//Visits every numPieces bit number with numRed bits set, in increasing order
+	for (std::uint64_t colouring = (static_cast<std::uint64_t>(1) << numRed) - 1; colouring < lastColouring;) {
+		BitboardType red = 0;
+		for (std::uint8_t x = 0; x < numPieces; x++) {
+			red |= static_cast<BitboardType>((colouring >> x) & 1) << squares[x];
+		}
+
+		const BitboardType yellow = occupied ^ red;
+
+		//Positions where the game is already over are never played from, so they stay UNKNOWN
+		if (!BoardT::isWinningMask(red) && !BoardT::isWinningMask(yellow)) {
+			const BitboardType current = mover == BoardT::RED_PIECE ? red : yellow;
+			std::uint8_t best = makeEntry(Outcome::DRAW, 0);
+
+			if (numPieces < NUM_CELLS) {
+				best = 0;
+
+				for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+					const BitboardType move = playable & BoardT::COL_MASKS[col];
+					if (!move) {
+						continue;
+					}
+
+					std::uint8_t result;
+					if (BoardT::isWinningMask(current | move)) {
+						result = makeEntry(Outcome::WIN, 1);
+					}
+					else {
+						const KeyType childKey = (mover == BoardT::RED_PIECE ? red | move : red) + (occupied | move) + BoardT::BOTTOM_MASK;
+						result = fromParent(entries[static_cast<std::size_t>(indexOf(childKey))]);
+					}
+
+					if (best == 0 || rankOf(result) > rankOf(best)) {
+						best = result;
+					}
+				}
+			}
+
+			entries[static_cast<std::size_t>(indexOf(red + occupied + BoardT::BOTTOM_MASK))] = best;
+			solved++;
+		}
+
+		if (colouring == 0) {
+			//The only colouring with no red pieces
+			break;
+		}
+
+		//Gosper's hack: the next larger number with the same number of bits set
+		const std::uint64_t lowest = colouring & (~colouring + 1);
+		const std::uint64_t ripple = colouring + lowest;
+		colouring = (((ripple ^ colouring) >> 2) / lowest) | ripple;
+	}
+
+	return solved;
+}
+
+template <class BoardT>
+std::uint8_t Tablebase<BoardT>::bestMove(const BoardT& board, const int& type) const
+{
+	if (outcomeOf(lookup(board, type)) == Outcome::UNKNOWN) {
+		return NO_MOVE;
+	}
+
+	const BitboardType current = board.getPieceMask(type);
+	const BitboardType occupied = board.getOccupiedMask();
+	const BitboardType playable = (occupied + BoardT::BOTTOM_MASK) & BoardT::BOARD_MASK;
+
+	std::uint8_t bestCol = NO_MOVE;
+	std::uint8_t best = 0;
+
+	for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+		const BitboardType move = playable & BoardT::COL_MASKS[col];
+		if (!move) {
+			continue;
+		}
+
+		if (BoardT::isWinningMask(current | move)) {
+			return col;
+		}
+
+		const BitboardType red = board.getPieceMask(BoardT::RED_PIECE) | (type == BoardT::RED_PIECE ? move : 0);
+		const std::uint8_t result = fromParent(lookup(red + (occupied | move) + BoardT::BOTTOM_MASK));
+
+		if (bestCol == NO_MOVE || rankOf(result) > rankOf(best)) {
+			bestCol = col;
+			best = result;
+		}
+	}
+
+	return bestCol;
+}
+
+template <class BoardT>
+bool Tablebase<BoardT>::write(const std::string& filename) const
+{
+	AtomicFile output(filename);
+
+	if (!output.isOpen() || !isLoaded()) {
+		return false;
+	}
+
+	std::array<char, HEADER_SIZE> header{};
+	std::copy(MAGIC.begin(), MAGIC.end(), header.begin());
+	storeLittleEndian(header.data() + 4, VERSION, 2);
+	storeLittleEndian(header.data() + 6, 1, 2);
+	header[8] = static_cast<char>(BoardT::NUM_ROWS);
+	header[9] = static_cast<char>(BoardT::NUM_COLS);
+	header[10] = static_cast<char>(BoardT::CONNECT_N);
+	storeLittleEndian(header.data() + 16, entries.size(), 8);
+	storeLittleEndian(header.data() + 24, numPositions, 8);
+
+	output.write(header.data(), HEADER_SIZE);
+	output.write(reinterpret_cast<const char*>(entries.data()), entries.size());
+	return output.commit();
+}
+
+template <class BoardT>
+bool Tablebase<BoardT>::read(const std::string& filename)
+{
+	entries.clear();
+	numPositions = 0;
+
+	std::ifstream input(filename, std::ifstream::in | std::ifstream::binary);
+	std::array<char, HEADER_SIZE> header;
+	input.read(header.data(), HEADER_SIZE);
+
+	const bool valid = input.gcount() == static_cast<std::streamsize>(HEADER_SIZE)
+		&& std::equal(MAGIC.begin(), MAGIC.end(), header.begin())
+		&& loadLittleEndian(header.data() + 4, 2) == VERSION
+		&& loadLittleEndian(header.data() + 6, 2) == 1
+		&& static_cast<std::uint8_t>(header[8]) == BoardT::NUM_ROWS
+		&& static_cast<std::uint8_t>(header[9]) == BoardT::NUM_COLS
+		&& static_cast<std::uint8_t>(header[10]) == BoardT::CONNECT_N
+		&& loadLittleEndian(header.data() + 16, 8) == NUM_ENTRIES;
+
+	if (!valid) {
+		return false;
+	}
+
+	entries.resize(static_cast<std::size_t>(NUM_ENTRIES));
+	input.read(reinterpret_cast<char*>(entries.data()), entries.size());
+
+	if (input.gcount() != static_cast<std::streamsize>(entries.size())) {
+		entries.clear();
+		return false;
+	}
+
+	numPositions = loadLittleEndian(header.data() + 24, 8);
+	return true;
+}
+
+template class Tablebase<Board4x5>;
+template class Tablebase<Board5x6>;
+template class Tablebase<Board6x7>;
@@ -0,0 +1,175 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Board.h"
+
+/*
+The perfect result of every position on the board, found by working backwards from the end of the game
+Every position is given one byte in a dense table, so looking a position up is a single memory access
+Positions are indexed by their columns: each column holding h pieces has 2 ^ h colourings, so a column is one of 2 ^ (NUM_ROWS + 1) - 1 states
+Yellow always moves first (as in Trainer and main), so the player to move is known from the number of pieces
+Only boards with few enough positions can be built (see MAX_ENTRIES), which in practice means the 4x5 board
+@param BoardT The type of board the tablebase is for
+*/
+template <class BoardT>
+class Tablebase
+{
+public:
+	typedef typename BoardT::KeyType KeyType;
+	typedef typename BoardT::BitboardType BitboardType;
+
+	//The result of a position for the player to move
+	enum class Outcome : std::uint8_t { UNKNOWN, WIN, LOSS, DRAW };
+
+	//The number of spaces on the board
+	static constexpr std::uint8_t NUM_CELLS = BoardT::NUM_ROWS * BoardT::NUM_COLS;
+
+	//The number of ways a column can be filled, from empty to full
+	static constexpr std::uint64_t COLUMN_STATES = (static_cast<std::uint64_t>(1) << BoardT::COL_HEIGHT) - 1;
+
+	//The amount each column's state is multiplied by in the index, which counts in base COLUMN_STATES
+	static constexpr std::array<std::uint64_t, BoardT::NUM_COLS> COLUMN_PLACES = [] {
+		std::array<std::uint64_t, BoardT::NUM_COLS> places{};
+		std::uint64_t place = 1;
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			places[col] = place;
+			place *= COLUMN_STATES;
+		}
+
+		return places;
+	}();
+
+	//The number of entries in the table, including the many that are not positions that can be reached
+	static constexpr std::uint64_t NUM_ENTRIES = COLUMN_PLACES[BoardT::NUM_COLS - 1] * COLUMN_STATES;
+
+	//The largest table that will be built
+	static constexpr std::uint64_t MAX_ENTRIES = static_cast<std::uint64_t>(1) << 32;
+
+	//The first bytes of every tablebase file
+	static constexpr std::array<char, 4> MAGIC = { 'C', '4', 'T', 'B' };
+	static constexpr std::uint16_t VERSION = 1;
+
+	//The header holds the magic, version, entry size, board dimensions, number of entries and number of positions solved
+	static constexpr std::size_t HEADER_SIZE = 32;
+
+	//Returned by bestMove when the position is not in the tablebase
+	static constexpr std::uint8_t NO_MOVE = UINT8_MAX;
+
+	static_assert(NUM_CELLS < 64, "Distances must fit within the low 6 bits of an entry");
+
+	Tablebase();
+
+	/*
+	Works out the result of every position, starting from full boards and moving back one piece at a time
+	Every position with n pieces only leads to positions with n + 1 pieces, so all of the positions with the same number of pieces are solved at once across threads
+	@param numThreads The number of threads to solve on
+	@return bool true if the tablebase was built or false if the board has too many positions
+	*/
+	bool generate(const unsigned int& numThreads);
+
+	/*
+	Writes the tablebase to a file
+	@param filename The file to write
+	@return bool true if the file was written or false otherwise
+	*/
+	bool write(const std::string& filename) const;
+
+	/*
+	Reads a tablebase written by write, replacing any tablebase already held
+	@param filename The file to read
+	@return bool true if the file was read or false if it could not be opened or is not a valid tablebase for this board
+	*/
+	bool read(const std::string& filename);
+
+	inline const bool isLoaded() const { return !entries.empty(); }
+
+	/*
+	Returns the entry of the given position, which describes the result for the player to move
+	@param key The key of the position (see Board::getKey)
+	@return std::uint8_t The entry, whose outcome is UNKNOWN if the position cannot be reached or the game is already over
+	*/
+	inline const std::uint8_t lookup(const KeyType& key) const { return entries[indexOf(key)]; }
+
+	/*
+	Returns the entry of the given board if it is the given player's turn
+	@param board The board
+	@param type The player to move (either RED_PIECE or YELLOW_PIECE)
+	@return std::uint8_t The entry, whose outcome is UNKNOWN if the tablebase does not hold the position for that player
+	*/
+	inline const std::uint8_t lookup(const BoardT& board, const int& type) const {
+		return isLoaded() && type == playerToMove(board.getNumPieces()) ? lookup(board.getKey()) : 0;
+	}
+
+	/*
+	Returns the column that leads to the best result for the player to move, winning as quickly or losing as slowly as possible
+	@param board The board
+	@param type The player to move (either RED_PIECE or YELLOW_PIECE)
+	@return std::uint8_t The best column or NO_MOVE if the position is not in the tablebase
+	*/
+	std::uint8_t bestMove(const BoardT& board, const int& type) const;
+
+	static inline constexpr Outcome outcomeOf(const std::uint8_t& entry) { return static_cast<Outcome>(entry >> 6); }
+
+	//The number of moves left in the game with perfect play, counting both players
+	static inline constexpr std::uint8_t distanceOf(const std::uint8_t& entry) { return entry & 63; }
+
+	static inline constexpr std::uint8_t makeEntry(const Outcome& outcome, const std::uint8_t& distance) { return static_cast<std::uint8_t>((static_cast<std::uint8_t>(outcome) << 6) | distance); }
+
+	/*
+	Returns the index of the given position in the table
+	Each column's bits in the key are the marker bit on top of its red pieces, which is one more than the column's state
+	@param key The key of the position (see Board::getKey)
+	@return std::uint64_t The index of the position
+	*/
+	static inline std::uint64_t indexOf(const KeyType& key) {
+		std::uint64_t index = 0;
+
+		for (std::uint8_t col = 0; col < BoardT::NUM_COLS; col++) {
+			index += (((key >> (col * BoardT::COL_HEIGHT)) & COLUMN_STATES) - 1) * COLUMN_PLACES[col];
+		}
+
+		return index;
+	}
+
+	/*
+	Returns the player whose turn it is once the given number of pieces have been played
+	@param numPieces The number of pieces on the board
+	@return int Either RED_PIECE or YELLOW_PIECE
+	*/
+	static inline constexpr int playerToMove(const std::uint8_t& numPieces) { return numPieces % 2 == 0 ? BoardT::YELLOW_PIECE : BoardT::RED_PIECE; }
+
+	//The number of positions that were solved by the last call to generate
+	inline const std::uint64_t getNumPositions() const { return numPositions; }
+
+private:
+	std::vector<std::uint8_t> entries;
+	std::uint64_t numPositions;
+
+	/*
+	Solves every position with the given heights of columns, reading the positions with one more piece
+	@param heights The number of pieces in each column
+	@return std::uint64_t The number of positions solved
+	*/
+	std::uint64_t solvePositions(const std::array<std::uint8_t, BoardT::NUM_COLS>& heights);
+
+	/*
+	Orders entries so that a larger rank is a better result for the player to move
+	@param entry An entry
+	@return int The rank of the entry
+	*/
+	static inline constexpr int rankOf(const std::uint8_t& entry) {
+		return outcomeOf(entry) == Outcome::WIN ? 128 - distanceOf(entry) : (outcomeOf(entry) == Outcome::DRAW ? 64 : distanceOf(entry));
+	}
+
+	/*
+	Returns the entry of a position for the player who moved into it, which is the opposite of the player to move
+	@param entry The entry for the player to move
+	@return std::uint8_t The entry for the other player, one move further from the end of the game
+	*/
+	static inline constexpr std::uint8_t fromParent(const std::uint8_t& entry) {
+		return makeEntry(outcomeOf(entry) == Outcome::WIN ? Outcome::LOSS : (outcomeOf(entry) == Outcome::LOSS ? Outcome::WIN : Outcome::DRAW), distanceOf(entry) + 1);
+	}
+};
@@ -0,0 +1,239 @@
+#include "Telemetry.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+std::uint64_t Telemetry::Histogram::percentile(const double& fraction) const
+{
+	if (samples == 0) {
+		return 0;
+	}
+
+	//The number of calls that must be at or below the time returned
+	const std::uint64_t target = std::max<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(fraction * samples)), 1);
+	std::uint64_t total = 0;
+
+	for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		total += buckets[bucket];
+
+		if (total >= target) {
+			return std::uint64_t(1) << (bucket + 1);
+		}
+	}
+
+	return std::uint64_t(1) << NUM_BUCKETS;
+}
+
+Telemetry::Snapshot Telemetry::Snapshot::since(const Snapshot& earlier) const
+{
+	Snapshot difference;
+
+	for (std::size_t x = 0; x < NUM_COUNTERS; x++) {
+		difference.counters[x] = counters[x] - earlier.counters[x];
+	}
+
+	for (std::size_t x = 0; x < NUM_TIMERS; x++) {
+		for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+			difference.timers[x].buckets[bucket] = timers[x].buckets[bucket] - earlier.timers[x].buckets[bucket];
+		}
+
+		difference.timers[x].calls = timers[x].calls - earlier.timers[x].calls;
+		difference.timers[x].samples = timers[x].samples - earlier.timers[x].samples;
+		difference.timers[x].totalNanoseconds = timers[x].totalNanoseconds - earlier.timers[x].totalNanoseconds;
+	}
+
+	difference.seconds = seconds - earlier.seconds;
+	return difference;
+}
+
+Telemetry::ThreadStats::ThreadStats()
+{
+	for (auto& counter : counters) {
+		counter.store(0, std::memory_order_relaxed);
+	}
+
+	for (std::size_t x = 0; x < NUM_TIMERS; x++) {
+		calls[x].store(0, std::memory_order_relaxed);
+		totalNanoseconds[x].store(0, std::memory_order_relaxed);
+
+		for (auto& bucket : buckets[x]) {
+			bucket.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void Telemetry::ThreadStats::record(const Timer& timer, const std::uint64_t& nanoseconds)
+{
+	const std::size_t index = static_cast<std::size_t>(timer);
+
+	//Find the highest set bit of the time, which is the bucket it falls in
+	std::size_t bucket = 0;
+	while (bucket < NUM_BUCKETS - 1 && (nanoseconds >> (bucket + 1)) != 0) {
+		bucket++;
+	}
+
+	increase(buckets[index][bucket], 1);
+	increase(totalNanoseconds[index], nanoseconds);
+}
+
+void Telemetry::ThreadStats::addTo(Snapshot& snapshot) const
+{
+	for (std::size_t x = 0; x < NUM_COUNTERS; x++) {
+		snapshot.counters[x] += counters[x].load(std::memory_order_relaxed);
+	}
+
+	for (std::size_t x = 0; x < NUM_TIMERS; x++) {
+		Histogram& histogram = snapshot.timers[x];
+
+		for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+			const std::uint64_t samples = buckets[x][bucket].load(std::memory_order_relaxed);
+
+			histogram.buckets[bucket] += samples;
+			histogram.samples += samples;
+		}
+
+		histogram.calls += calls[x].load(std::memory_order_relaxed);
+		histogram.totalNanoseconds += totalNanoseconds[x].load(std::memory_order_relaxed);
+	}
+}
+
+Telemetry::Telemetry(const unsigned int& numThreads)
+	: start(std::chrono::steady_clock::now()), initialBoards(0), output(nullptr), stopping(false)
+{
+	for (unsigned int x = 0; x < std::max(numThreads, 1u); x++) {
+		threads.push_back(std::make_unique<ThreadStats>());
+	}
+}
+
+Telemetry::~Telemetry()
+{
+	stopReporting();
+}
+
+Telemetry::Snapshot Telemetry::snapshot() const
+{
+	Snapshot totals;
+
+	for (auto& thread : threads) {
+		thread->addTo(totals);
+	}
+
+	totals.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return totals;
+}
+
+bool Telemetry::startReporting(const double& intervalSeconds, std::ostream& output, const std::string& statsFilename, const std::uint64_t& initialBoards)
+{
+	stopReporting();
+
+	if (!statsFilename.empty()) {
+		statsFile.open(statsFilename, std::ofstream::app);
+
+		if (!statsFile.is_open()) {
+			return false;
+		}
+	}
+
+	this->output = &output;
+	this->initialBoards = initialBoards;
+	start = std::chrono::steady_clock::now();
+	firstReport = snapshot();
+	lastReport = firstReport;
+	stopping = false;
+
+	const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(intervalSeconds));
+	reporter = std::thread(&Telemetry::runReporter, this, interval);
+	return true;
+}
+
+void Telemetry::stopReporting()
+{
+	if (!reporter.joinable()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	wake.notify_all();
+	reporter.join();
+
+	//Sum up the whole run, which also reports runs shorter than the interval
+	report(true);
+
+	if (statsFile.is_open()) {
+		statsFile.close();
+	}
+}
+
+void Telemetry::runReporter(const std::chrono::steady_clock::duration& interval)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	auto nextReport = std::chrono::steady_clock::now() + interval;
+
+	while (!wake.wait_until(lock, nextReport, [this]() { return stopping; })) {
+		lock.unlock();
+		report(false);
+		lock.lock();
+
+		nextReport += interval;
+	}
+}
+
+void Telemetry::report(const bool& final)
+{
+	const Snapshot current = snapshot();
+	const Snapshot interval = current.since(final ? firstReport : lastReport);
+	lastReport = current;
+
+	const std::uint64_t games = interval.get(Counter::GAMES);
+	const double gamesPerSecond = interval.seconds > 0 ? games / interval.seconds : 0;
+	const double percent = games > 0 ? 100.0 / games : 0;
+	const Snapshot run = current.since(firstReport);
+	const std::uint64_t boards = initialBoards + run.get(Counter::NEW_BOARDS) - run.get(Counter::EVICTED_BOARDS) - run.get(Counter::ERASED_BOARDS);
+	const double newBoards = static_cast<double>(interval.get(Counter::NEW_BOARDS));
+	const double lostBoards = static_cast<double>(interval.get(Counter::EVICTED_BOARDS) + interval.get(Counter::ERASED_BOARDS));
+	const double boardsPerSecond = interval.seconds > 0 ? (newBoards - lostBoards) / interval.seconds : 0;
+	const Histogram& makeMove = interval.get(Timer::MAKE_MOVE);
+	const Histogram& learnFromGame = interval.get(Timer::LEARN_FROM_GAME);
+
+	//The rates, win split and times are of the last interval, so they show how training is changing, except in the last report which sums up the run
+	std::ostringstream line;
+	line << std::fixed << std::setprecision(1) << (final ? "[Total, " : "[") << current.seconds << " s] " << current.get(Counter::GAMES) << " games ("
+		<< static_cast<std::uint64_t>(gamesPerSecond) << " per second), AI 1 won " << interval.get(Counter::AI1_WINS) * percent << "%, AI 2 won "
+		<< interval.get(Counter::AI2_WINS) * percent << "%, " << interval.get(Counter::DRAWS) * percent << "% drawn, " << boards << " boards ("
+		<< std::showpos << static_cast<std::int64_t>(boardsPerSecond) << std::noshowpos << " per second, " << (games > 0 ? newBoards / games : 0)
+		<< " new per game, " << interval.get(Counter::DROPPED_UPDATES) << " updates dropped), makeMove p50 " << makeMove.percentile(0.5) << " ns p99 " << makeMove.percentile(0.99) << " ns, learnFromGame p50 "
+		<< learnFromGame.percentile(0.5) << " ns p99 " << learnFromGame.percentile(0.99) << " ns\n";
+	*output << line.str() << std::flush;
+
+	if (!statsFile.is_open()) {
+		return;
+	}
+
+	//Every total in the file is a running total, so any two lines can be compared
+	statsFile << std::setprecision(6) << "{\"seconds\":" << current.seconds << ",\"games\":" << current.get(Counter::GAMES)
+		<< ",\"games_per_second\":" << gamesPerSecond << ",\"ai1_wins\":" << current.get(Counter::AI1_WINS) << ",\"ai2_wins\":"
+		<< current.get(Counter::AI2_WINS) << ",\"draws\":" << current.get(Counter::DRAWS) << ",\"boards\":" << boards << ",\"new_boards\":"
+		<< current.get(Counter::NEW_BOARDS) << ",\"evicted_boards\":" << current.get(Counter::EVICTED_BOARDS) << ",\"erased_boards\":" << current.get(Counter::ERASED_BOARDS)
+		<< ",\"dropped_updates\":" << current.get(Counter::DROPPED_UPDATES) << ",\"make_move\":";
+	writeHistogram(statsFile, current.get(Timer::MAKE_MOVE));
+	statsFile << ",\"learn_from_game\":";
+	writeHistogram(statsFile, current.get(Timer::LEARN_FROM_GAME));
+	statsFile << "}" << std::endl;
+}
+
+void Telemetry::writeHistogram(std::ostream& output, const Histogram& histogram)
+{
+	output << "{\"calls\":" << histogram.calls << ",\"samples\":" << histogram.samples << ",\"mean_ns\":" << histogram.meanNanoseconds()
+		<< ",\"p50_ns\":" << histogram.percentile(0.5) << ",\"p99_ns\":" << histogram.percentile(0.99) << ",\"buckets\":[";
+
+	for (std::size_t bucket = 0; bucket < NUM_BUCKETS; bucket++) {
+		output << (bucket == 0 ? "" : ",") << histogram.buckets[bucket];
+	}
+
+	output << "]}";
+}
@@ -0,0 +1,266 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Defining CONNECT4_TELEMETRY as 0 when building removes every counter and timer, so the training loop is exactly as it would be without them
+#ifndef CONNECT4_TELEMETRY
+#define CONNECT4_TELEMETRY 1
+#endif
+
+/*
+Counts what the training threads do and times their moves, and reports the totals every few seconds
+Every thread only writes to its own counters, so counting never waits for another thread or shares a cache line with one
+*/
+class Telemetry
+{
+public:
+	static constexpr bool ENABLED = CONNECT4_TELEMETRY != 0;
+
+	//Boards are evicted to keep to a memory limit, and erased once every move from them has been learned to lose
+	//An update is dropped when a game learns about a board that was evicted or erased after the game moved on it
+	enum class Counter { GAMES, AI1_WINS, AI2_WINS, DRAWS, NEW_BOARDS, EVICTED_BOARDS, ERASED_BOARDS, DROPPED_UPDATES, NUM_COUNTERS };
+	enum class Timer { MAKE_MOVE, LEARN_FROM_GAME, NUM_TIMERS };
+
+	static constexpr std::size_t NUM_COUNTERS = static_cast<std::size_t>(Counter::NUM_COUNTERS);
+	static constexpr std::size_t NUM_TIMERS = static_cast<std::size_t>(Timer::NUM_TIMERS);
+
+	//Bucket n of a histogram counts the calls that took from 2^n up to 2^(n + 1) nanoseconds, and the last bucket also counts everything slower
+	static constexpr std::size_t NUM_BUCKETS = 32;
+
+	//Only one call in this many is timed, since reading the clock takes about as long as a move
+	static constexpr std::uint64_t SAMPLE_INTERVAL = 64;
+
+	/*
+	The timed calls of one function
+	*/
+	struct Histogram
+	{
+		std::array<std::uint64_t, NUM_BUCKETS> buckets{};
+		std::uint64_t calls = 0;
+		std::uint64_t samples = 0;
+		std::uint64_t totalNanoseconds = 0;
+
+		inline double meanNanoseconds() const { return samples > 0 ? static_cast<double>(totalNanoseconds) / samples : 0; }
+
+		/*
+		Finds the time that the given fraction of the timed calls took no longer than, rounded up to a power of 2
+		@param fraction The fraction of the calls, such as 0.99 for the 99th percentile
+		@return std::uint64_t The time in nanoseconds, or 0 if nothing was timed
+		*/
+		std::uint64_t percentile(const double& fraction) const;
+	};
+
+	/*
+	The totals of every thread at one moment
+	*/
+	struct Snapshot
+	{
+		std::array<std::uint64_t, NUM_COUNTERS> counters{};
+		std::array<Histogram, NUM_TIMERS> timers;
+
+		//The time since reporting started
+		double seconds = 0;
+
+		inline std::uint64_t get(const Counter& counter) const { return counters[static_cast<std::size_t>(counter)]; }
+		inline const Histogram& get(const Timer& timer) const { return timers[static_cast<std::size_t>(timer)]; }
+
+		/*
+		Finds what happened between an earlier snapshot and this one
+		@param earlier The earlier snapshot
+		@return Snapshot The differences between the two
+		*/
+		Snapshot since(const Snapshot& earlier) const;
+	};
+
+	/*
+	The counters of one thread, which only that thread writes to and any thread may read
+	*/
+	class alignas(64) ThreadStats
+	{
+	public:
+		ThreadStats();
+
+		/*
+		Adds to one of the counters
+		@param counter The counter
+		@param amount The amount to add
+		*/
+		inline void add(const Counter& counter, const std::uint64_t& amount) {
+			increase(counters[static_cast<std::size_t>(counter)], amount);
+		}
+
+		/*
+		Counts a call to the given function and decides whether to time it
+		@param timer The function being called
+		@return bool true if the call is to be timed
+		*/
+		inline bool startCall(const Timer& timer) {
+			std::atomic<std::uint64_t>& count = calls[static_cast<std::size_t>(timer)];
+			const std::uint64_t call = count.load(std::memory_order_relaxed);
+
+			count.store(call + 1, std::memory_order_relaxed);
+			return call % SAMPLE_INTERVAL == 0;
+		}
+
+		/*
+		Adds the time a call took to the histogram of its function
+		@param timer The function that was called
+		@param nanoseconds The time the call took
+		*/
+		void record(const Timer& timer, const std::uint64_t& nanoseconds);
+
+		/*
+		Adds the counters of this thread to a snapshot
+		@param snapshot The snapshot to add to
+		*/
+		void addTo(Snapshot& snapshot) const;
+
+	private:
+		std::array<std::atomic<std::uint64_t>, NUM_COUNTERS> counters;
+		std::array<std::atomic<std::uint64_t>, NUM_TIMERS> calls;
+		std::array<std::atomic<std::uint64_t>, NUM_TIMERS> totalNanoseconds;
+		std::array<std::array<std::atomic<std::uint64_t>, NUM_BUCKETS>, NUM_TIMERS> buckets;
+
+		//Only one thread writes to each counter, so it can be increased without a locked instruction
+		static inline void increase(std::atomic<std::uint64_t>& value, const std::uint64_t& amount) {
+			value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+		}
+	};
+
+	/*
+	Times the scope it is declared in, if the call is one of those sampled
+	*/
+	class ScopedTimer
+	{
+	public:
+		/*
+		Counts the call and starts timing it if it is sampled
+		@param stats The counters of the current thread, or nullptr to do nothing
+		@param timer The function being called
+		*/
+		inline ScopedTimer(ThreadStats* stats, const Timer& timer)
+			: stats(nullptr), timer(timer)
+		{
+			if (ENABLED && stats != nullptr && stats->startCall(timer)) {
+				this->stats = stats;
+				start = std::chrono::steady_clock::now();
+			}
+		}
+
+		inline ~ScopedTimer() {
+			if (ENABLED && stats != nullptr) {
+				stats->record(timer, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+			}
+		}
+
+		ScopedTimer(const ScopedTimer&) = delete;
+		ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+	private:
+		ThreadStats* stats;
+		Timer timer;
+		std::chrono::steady_clock::time_point start;
+	};
+
+	/*
+	Adds to one of the counters of the current thread
+	@param stats The counters of the current thread, or nullptr to do nothing
+	@param counter The counter
+	@param amount The amount to add
+	*/
+	static inline void count(ThreadStats* stats, const Counter& counter, const std::uint64_t& amount = 1) {
+		if (ENABLED && stats != nullptr) {
+			stats->add(counter, amount);
+		}
+	}
+
+	/*
+	Creates the counters of the given number of threads
+	@param numThreads The number of threads that will be counted
+	*/
+	Telemetry(const unsigned int& numThreads);
+
+	/*
+	Stops reporting
+	*/
+	~Telemetry();
+
+	Telemetry(const Telemetry&) = delete;
+	Telemetry& operator=(const Telemetry&) = delete;
+
+	/*
+	Returns the counters of one thread
+	@param thread The index of the thread
+	@return ThreadStats* The counters of the thread
+	*/
+	inline ThreadStats* getThreadStats(const unsigned int& thread) { return threads.at(thread).get(); }
+
+	inline const unsigned int getNumThreads() const { return static_cast<unsigned int>(threads.size()); }
+
+	/*
+	Adds up the counters of every thread
+	@return Snapshot The totals
+	*/
+	Snapshot snapshot() const;
+
+	/*
+	Starts a thread that reports the totals every interval as one line of text and, optionally, one line of JSON appended to a file
+	@param intervalSeconds The number of seconds between reports
+	@param output Where the lines of text are written
+	@param statsFilename The file the JSON lines are appended to, or an empty string for none
+	@param initialBoards The number of boards both AI objects held before training, which the new boards are added to and the evicted and erased boards taken from
+	@return bool true if reporting started or false if the file could not be opened
+	*/
+	bool startReporting(const double& intervalSeconds, std::ostream& output, const std::string& statsFilename, const std::uint64_t& initialBoards);
+
+	/*
+	Writes a last report and stops the reporting thread, if it was started
+	*/
+	void stopReporting();
+
+private:
+	std::vector<std::unique_ptr<ThreadStats>> threads;
+
+	std::chrono::steady_clock::time_point start;
+	std::uint64_t initialBoards;
+	std::ostream* output;
+	std::ofstream statsFile;
+
+	//The snapshots reporting started from and the last report was made from, which the rates of the last and the next report are measured from
+	Snapshot firstReport;
+	Snapshot lastReport;
+
+	std::thread reporter;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+
+	/*
+	Reports the totals every interval until stopping is set
+	@param interval The time between reports
+	*/
+	void runReporter(const std::chrono::steady_clock::duration& interval);
+
+	/*
+	Writes the line of text and the JSON line of the current totals
+	@param final true to measure the rates from when reporting started instead of from the last report
+	*/
+	void report(const bool& final);
+
+	/*
+	Writes a histogram as a JSON object
+	@param output The stream to write to
+	@param histogram The histogram
+	*/
+	static void writeHistogram(std::ostream& output, const Histogram& histogram);
+};
@@ -0,0 +1,384 @@
+#include "Trainer.h"
+#include <algorithm>
+#include <thread>
+
+template <class BoardT>
+void Trainer<BoardT>::Results::add(const Results& other)
+{
+	gamesPlayed += other.gamesPlayed;
+	ai1Wins += other.ai1Wins;
+	ai2Wins += other.ai2Wins;
+	draws += other.draws;
+	seconds = std::max(seconds, other.seconds);
+}
+
+template <class BoardT>
+Trainer<BoardT>::Trainer(AI<BoardT>& ai1, AI<BoardT>& ai2, const unsigned int& numThreads, const std::uint64_t& seed)
+	: ai1(ai1), ai2(ai2), numThreads(std::max(numThreads, 1u)), seeds(seed), batchSize(1), gamesClaimed(0), gamesPlayed(0), runningThreads(0)
+{}
+
+template <class BoardT>
+Trainer<BoardT>::~Trainer()
+{
+	if (!threads.empty()) {
+		finish();
+	}
+}
+
+template <class BoardT>
+typename Trainer<BoardT>::Results Trainer<BoardT>::train(const std::uint64_t& maxGames, const std::atomic<bool>& stop, const double& maxSeconds)
+{
+	if (numThreads > 1) {
+		start(maxGames, stop, maxSeconds);
+		return finish();
+	}
+
+	//Train on the current thread, where the data does not need to be locked
+	startTime = std::chrono::steady_clock::now();
+	gamesClaimed = 0;
+	gamesPlayed = 0;
+
+	Results results;
+	runWorker(0, seeds.next(), seeds.next(), maxGames, stop, deadlineAfter(maxSeconds), results);
+
+	results.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	return results;
+}
+
+template <class BoardT>
+void Trainer<BoardT>::start(const std::uint64_t& maxGames, const std::atomic<bool>& stop, const double& maxSeconds)
+{
+	startTime = std::chrono::steady_clock::now();
+	const auto deadline = deadlineAfter(maxSeconds);
+
+	gamesClaimed = 0;
+	gamesPlayed = 0;
+	threadResults.assign(numThreads, Results());
+	runningThreads = numThreads;
+
+	ai1.getSharedData()->setConcurrent(true);
+	ai2.getSharedData()->setConcurrent(true);
+
+	for (unsigned int x = 0; x < numThreads; x++) {
+		const std::uint64_t seed1 = seeds.next();
+		const std::uint64_t seed2 = seeds.next();
+
+		threads.emplace_back([this, x, seed1, seed2, maxGames, &stop, deadline]() {
+			runWorker(x, seed1, seed2, maxGames, stop, deadline, threadResults[x]);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				runningThreads--;
+
+				if (runningThreads == 0) {
+					stopTime = std::chrono::steady_clock::now();
+				}
+			}
+
+			stopped.notify_all();
+		});
+	}
+}
+
+template <class BoardT>
+bool Trainer<BoardT>::wait(const double& maxSeconds)
+{
+	std::unique_lock<std::mutex> lock(mutex);
+
+	if (maxSeconds <= 0) {
+		stopped.wait(lock, [this]() { return runningThreads == 0; });
+		return true;
+	}
+
+	return stopped.wait_for(lock, std::chrono::duration<double>(maxSeconds), [this]() { return runningThreads == 0; });
+}
+
+template <class BoardT>
+typename Trainer<BoardT>::Results Trainer<BoardT>::finish()
+{
+	for (auto& thread : threads) {
+		thread.join();
+	}
+
+	threads.clear();
+
+	ai1.getSharedData()->setConcurrent(false);
+	ai2.getSharedData()->setConcurrent(false);
+
+	Results results;
+	for (auto& threadResult : threadResults) {
+		results.add(threadResult);
+	}
+
+	//Whatever the caller did after the threads stopped is not part of training
+	results.seconds = std::chrono::duration<double>(stopTime - startTime).count();
+	return results;
+}
+
+template <class BoardT>
+typename Trainer<BoardT>::GameResult Trainer<BoardT>::playGame(BoardT& board, AI<BoardT>& ai1, AI<BoardT>& ai2)
+{
+	//Keep track of the number of moves the game takes
+	std::uint8_t numMoves = 0;
+
+	board.clearBoard();
+
+	while (true) {
+		numMoves++;
+
+		if (board.checkForWin(ai1.makeMove(board))) {
+			ai1.learnFromGame(numMoves, true);
+			ai2.learnFromGame(numMoves, false);
+			return GameResult::AI1_WON;
+		}
+
+		if (board.isFull()) {
+			break;
+		}
+
+		if (board.checkForWin(ai2.makeMove(board))) {
+			ai1.learnFromGame(numMoves, false);
+			ai2.learnFromGame(numMoves, true);
+			return GameResult::AI2_WON;
+		}
+
+		if (board.isFull()) {
+			break;
+		}
+	}
+
+	//Nobody won, so there is nothing to learn
+	ai1.endCurrentGame();
+	ai2.endCurrentGame();
+	return GameResult::DRAW;
+}
+
+template <class BoardT>
+void Trainer<BoardT>::runWorker(const unsigned int& thread, const std::uint64_t& seed1, const std::uint64_t& seed2, const std::uint64_t& maxGames, const std::atomic<bool>& stop,
+	const std::chrono::steady_clock::time_point& deadline, Results& results)
+{
+	BoardT board;
+
+	//These learn into the data of the AI objects being trained, but keep their own games and random numbers
+	AI<BoardT> worker1(BoardT::YELLOW_PIECE, seed1, ai1.getSharedData());
+	AI<BoardT> worker2(BoardT::RED_PIECE, seed2, ai2.getSharedData());
+	worker1.useTactics(ai1.usesTactics());
+	worker2.useTactics(ai2.usesTactics());
+
+	//Both AI objects play on this thread, so they share its counters
+	Telemetry::ThreadStats* stats = telemetry != nullptr ? telemetry->getThreadStats(thread) : nullptr;
+	worker1.useTelemetry(stats);
+	worker2.useTelemetry(stats);
+
+	if (batchSize > 1) {
+		runBatches(worker1, worker2, stats, maxGames, stop, deadline, results);
+		return;
+	}
+
+	while (!stop.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < deadline) {
+		std::uint64_t gamesToPlay = GAMES_PER_BATCH;
+
+		if (maxGames != 0) {
+			//Claim the next batch of games so the threads never play more than the limit between them
+			const std::uint64_t firstGame = gamesClaimed.fetch_add(GAMES_PER_BATCH, std::memory_order_relaxed);
+
+			if (firstGame >= maxGames) {
+				break;
+			}
+
+			gamesToPlay = std::min(GAMES_PER_BATCH, maxGames - firstGame);
+		}
+
+		for (std::uint64_t game = 0; game < gamesToPlay; game++) {
+			Telemetry::count(stats, Telemetry::Counter::GAMES);
+
+			switch (playGame(board, worker1, worker2)) {
+			case GameResult::AI1_WON:
+				results.ai1Wins++;
+				Telemetry::count(stats, Telemetry::Counter::AI1_WINS);
+				break;
+			case GameResult::AI2_WON:
+				results.ai2Wins++;
+				Telemetry::count(stats, Telemetry::Counter::AI2_WINS);
+				break;
+			case GameResult::DRAW:
+				results.draws++;
+				Telemetry::count(stats, Telemetry::Counter::DRAWS);
+				break;
+			}
+		}
+
+		results.gamesPlayed += gamesToPlay;
+		gamesPlayed.fetch_add(gamesToPlay, std::memory_order_relaxed);
+	}
+}
+
+template <class BoardT>
+void Trainer<BoardT>::runBatches(AI<BoardT>& worker1, AI<BoardT>& worker2, Telemetry::ThreadStats* stats, const std::uint64_t& maxGames, const std::atomic<bool>& stop,
+	const std::chrono::steady_clock::time_point& deadline, Results& results)
+{
+	//Marks a place in the batch that has no game being played in it
+	const std::size_t NO_GAME = SIZE_MAX;
+
+	BoardBatch<BoardT> boards(batchSize);
+	const std::size_t numLanes = boards.size();
+
+	//Finished games wait to be learned from while new games are played in their place, so there are twice as many games as places
+	std::vector<BatchGame> games(numLanes * 2);
+	std::vector<std::size_t> freeGames;
+	std::vector<std::size_t> finishedGames;
+	std::vector<std::size_t> laneGames(numLanes, NO_GAME);
+
+	std::vector<std::uint8_t> columns(numLanes, 0);
+	std::vector<typename BoardBatch<BoardT>::Outcome> outcomes(numLanes);
+
+	for (std::size_t x = games.size(); x-- > 0;) {
+		freeGames.push_back(x);
+	}
+
+	std::size_t activeLanes = 0;
+	std::uint64_t gamesToStart = 0;
+	bool starting = true;
+
+	while (true) {
+		starting = starting && !stop.load(std::memory_order_relaxed) && std::chrono::steady_clock::now() < deadline;
+
+		//Start a new game in every place that is free, claiming the games in batches like runWorker does
+		for (std::size_t lane = 0; starting && lane < numLanes; lane++) {
+			if (laneGames[lane] != NO_GAME) {
+				continue;
+			}
+
+			if (gamesToStart == 0) {
+				gamesToStart = GAMES_PER_BATCH;
+
+				if (maxGames != 0) {
+					const std::uint64_t firstGame = gamesClaimed.fetch_add(GAMES_PER_BATCH, std::memory_order_relaxed);
+
+					if (firstGame >= maxGames) {
+						starting = false;
+						break;
+					}
+
+					gamesToStart = std::min(GAMES_PER_BATCH, maxGames - firstGame);
+				}
+			}
+
+			gamesToStart--;
+
+			laneGames[lane] = freeGames.back();
+			freeGames.pop_back();
+			games[laneGames[lane]].trajectories[BoardT::YELLOW_PIECE].clear();
+			games[laneGames[lane]].trajectories[BoardT::RED_PIECE].clear();
+			boards.clearBoard(lane);
+			activeLanes++;
+		}
+
+		if (activeLanes == 0) {
+			break;
+		}
+
+		//Load the priorities of every board first, so the lookups of different games wait for memory at the same time instead of one after another
+		for (std::size_t lane = 0; lane < numLanes; lane++) {
+			if (laneGames[lane] != NO_GAME) {
+				(boards.getTurn(lane) == BoardT::YELLOW_PIECE ? worker1 : worker2).prefetchPriorities(boards.getKey(lane));
+			}
+		}
+
+		for (std::size_t lane = 0; lane < numLanes; lane++) {
+			if (laneGames[lane] == NO_GAME) {
+				continue;
+			}
+
+			const int turn = boards.getTurn(lane);
+			const typename BoardT::KeyType key = boards.getKey(lane);
+
+			columns[lane] = (turn == BoardT::YELLOW_PIECE ? worker1 : worker2).chooseMove(key, boards.getMoverMask(lane), boards.getOccupiedMask(lane));
+			games[laneGames[lane]].trajectories[turn].record(key, columns[lane]);
+		}
+
+		boards.dropPieces(columns.data(), outcomes.data());
+
+		for (std::size_t lane = 0; lane < numLanes; lane++) {
+			if (laneGames[lane] == NO_GAME || outcomes[lane] == BoardBatch<BoardT>::Outcome::ONGOING) {
+				continue;
+			}
+
+			//The first player made the last move if there is an odd number of pieces
+			const std::uint8_t numPieces = boards.getNumPieces(lane);
+			BatchGame& game = games[laneGames[lane]];
+
+			if (outcomes[lane] == BoardBatch<BoardT>::Outcome::WIN) {
+				game.result = numPieces & 1 ? GameResult::AI1_WON : GameResult::AI2_WON;
+			}
+			else {
+				game.result = GameResult::DRAW;
+			}
+
+			game.turnsTaken = static_cast<std::uint8_t>((numPieces + 1) / 2);
+			finishedGames.push_back(laneGames[lane]);
+			laneGames[lane] = NO_GAME;
+			activeLanes--;
+		}
+
+		//Learning from many games in a row keeps the learning code and the boards it changes in the cache
+		if (finishedGames.size() >= numLanes) {
+			learnFromBatch(worker1, worker2, stats, games, finishedGames, freeGames, results);
+		}
+	}
+
+	learnFromBatch(worker1, worker2, stats, games, finishedGames, freeGames, results);
+}
+
+template <class BoardT>
+void Trainer<BoardT>::learnFromBatch(AI<BoardT>& worker1, AI<BoardT>& worker2, Telemetry::ThreadStats* stats, std::vector<BatchGame>& games,
+	std::vector<std::size_t>& finishedGames, std::vector<std::size_t>& freeGames, Results& results)
+{
+	for (const std::size_t index : finishedGames) {
+		const BatchGame& game = games[index];
+		const auto& moves1 = game.trajectories[BoardT::YELLOW_PIECE];
+		const auto& moves2 = game.trajectories[BoardT::RED_PIECE];
+
+		Telemetry::count(stats, Telemetry::Counter::GAMES);
+
+		switch (game.result) {
+		case GameResult::AI1_WON:
+			worker1.learnFromTrajectory(moves1, game.turnsTaken, true);
+			worker2.learnFromTrajectory(moves2, game.turnsTaken, false);
+			results.ai1Wins++;
+			Telemetry::count(stats, Telemetry::Counter::AI1_WINS);
+			break;
+		case GameResult::AI2_WON:
+			worker1.learnFromTrajectory(moves1, game.turnsTaken, false);
+			worker2.learnFromTrajectory(moves2, game.turnsTaken, true);
+			results.ai2Wins++;
+			Telemetry::count(stats, Telemetry::Counter::AI2_WINS);
+			break;
+		case GameResult::DRAW:
+			//Nobody won, so there is nothing to learn
+			results.draws++;
+			Telemetry::count(stats, Telemetry::Counter::DRAWS);
+			break;
+		}
+
+		freeGames.push_back(index);
+	}
+
+	results.gamesPlayed += finishedGames.size();
+	gamesPlayed.fetch_add(finishedGames.size(), std::memory_order_relaxed);
+	finishedGames.clear();
+}
+
+template <class BoardT>
+std::chrono::steady_clock::time_point Trainer<BoardT>::deadlineAfter(const double& maxSeconds)
+{
+	if (maxSeconds <= 0) {
+		return std::chrono::steady_clock::time_point::max();
+	}
+
+	return std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(maxSeconds));
+}
+
+template class Trainer<Board4x5>;
+template class Trainer<Board5x6>;
+template class Trainer<Board6x7>;
@@ -0,0 +1,219 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Board.h"
+#include "AI.h"
+#include "BoardBatch.h"
+#include "Telemetry.h"
+
+/*
+Trains two AI objects against each other, optionally on several threads at once
+Every thread plays its own games with its own AI objects, which all learn into the data of the two AI objects being trained
+@param BoardT The type of board the games are played on
+*/
+template <class BoardT>
+class Trainer
+{
+public:
+	enum class GameResult { AI1_WON, AI2_WON, DRAW };
+
+	/*
+	The totals of a training run
+	*/
+	struct Results
+	{
+		std::uint64_t gamesPlayed = 0;
+		std::uint64_t ai1Wins = 0;
+		std::uint64_t ai2Wins = 0;
+		std::uint64_t draws = 0;
+		double seconds = 0;
+
+		inline double gamesPerSecond() const { return seconds > 0 ? gamesPlayed / seconds : 0; }
+
+		/*
+		Adds the totals of another run to these totals, keeping the longer of the two durations
+		@param other The totals to add
+		*/
+		void add(const Results& other);
+	};
+
+	//The number of games a thread plays between checks of the stop flag and the game limit
+	static constexpr std::uint64_t GAMES_PER_BATCH = 256;
+
+	/*
+	Prepares to train the given AI objects
+	@param ai1 The AI that moves first (playing YELLOW_PIECE)
+	@param ai2 The AI that moves second (playing RED_PIECE)
+	@param numThreads The number of threads to train on (at least 1)
+	@param seed Generates the seeds of the AI objects on every thread
+	*/
+	Trainer(AI<BoardT>& ai1, AI<BoardT>& ai2, const unsigned int& numThreads, const std::uint64_t& seed);
+
+	/*
+	Waits for any threads started by start that finish was not called for
+	*/
+	~Trainer();
+
+	Trainer(const Trainer&) = delete;
+	Trainer& operator=(const Trainer&) = delete;
+
+	/*
+	Plays games until the game limit or the time limit is reached or stop becomes true
+	@param maxGames The number of games to play (0 for no limit)
+	@param stop Set to true by another thread (or a signal handler) to end training early
+	@param maxSeconds The number of seconds to play for (0 for no limit)
+	@return Results The totals of the games played
+	*/
+	Results train(const std::uint64_t& maxGames, const std::atomic<bool>& stop, const double& maxSeconds = 0);
+
+	/*
+	Starts playing games on threads of their own, which carry on until the game limit or the time limit is reached or stop becomes true
+	The data of both AI objects stays concurrent until finish is called, even on one thread, so it can be read or saved while the games carry on
+	@param maxGames The number of games to play (0 for no limit)
+	@param stop Set to true by another thread (or a signal handler) to end training early, which must exist until finish is called
+	@param maxSeconds The number of seconds to play for (0 for no limit)
+	*/
+	void start(const std::uint64_t& maxGames, const std::atomic<bool>& stop, const double& maxSeconds = 0);
+
+	/*
+	Waits until every thread started by start has stopped playing, or until the given time has passed
+	@param maxSeconds The longest time to wait (0 for no limit)
+	@return bool true if every thread has stopped or false if the time ran out first
+	*/
+	bool wait(const double& maxSeconds);
+
+	/*
+	Waits for the threads started by start to stop and adds up the games they played
+	@return Results The totals of the games played since start was called
+	*/
+	Results finish();
+
+	/*
+	Returns the number of games finished since training last started, which is counted while the games are played
+	@return std::uint64_t The number of games
+	*/
+	inline const std::uint64_t getGamesPlayed() const { return gamesPlayed.load(std::memory_order_relaxed); }
+
+	/*
+	Plays one game on the given board and teaches both AI objects the result
+	@param board The board to play on, which is cleared first
+	@param ai1 The AI that moves first
+	@param ai2 The AI that moves second
+	@return GameResult The result of the game
+	*/
+	static GameResult playGame(BoardT& board, AI<BoardT>& ai1, AI<BoardT>& ai2);
+
+	inline const unsigned int getNumThreads() const { return numThreads; }
+
+	/*
+	Makes every training thread count its games and time its moves
+	@param telemetry The counters, with at least one set per thread, or nullptr to stop counting
+	*/
+	inline void useTelemetry(const std::shared_ptr<Telemetry>& telemetry) { this->telemetry = telemetry; }
+
+	/*
+	Makes every thread play the given number of games at once, making one move in all of them before the next (see BoardBatch)
+	Finished games are learned from together, and a new game starts in the place of each one
+	@param games The number of games each thread plays at once, where 1 plays one game at a time as playGame does
+	*/
+	inline void setBatchSize(const std::size_t& games) { batchSize = std::max<std::size_t>(games, 1); }
+
+	inline const std::size_t getBatchSize() const { return batchSize; }
+
+private:
+	AI<BoardT>& ai1;
+	AI<BoardT>& ai2;
+	unsigned int numThreads;
+	Random seeds;
+
+	//Counts what every thread does while set (see useTelemetry)
+	std::shared_ptr<Telemetry> telemetry;
+
+	//The number of games each thread plays at once (see setBatchSize)
+	std::size_t batchSize;
+
+	/*
+	A game played as part of a batch, which is kept until it has been learned from
+	*/
+	struct BatchGame
+	{
+		//The boards each AI moved on and the moves it chose, indexed by the piece it plays
+		std::array<typename AI<BoardT>::Trajectory, 2> trajectories;
+
+		GameResult result;
+
+		//The number of moves the first player made
+		std::uint8_t turnsTaken;
+	};
+
+	//The number of games the threads have started, used to share the game limit between them
+	std::atomic<std::uint64_t> gamesClaimed;
+
+	//The number of games the threads have finished, added to once per batch (see getGamesPlayed)
+	std::atomic<std::uint64_t> gamesPlayed;
+
+	//The threads started by start, the totals each of them sets once it stops and the times the first was started and the last stopped
+	std::vector<std::thread> threads;
+	std::vector<Results> threadResults;
+	std::chrono::steady_clock::time_point startTime;
+	std::chrono::steady_clock::time_point stopTime;
+
+	//The number of threads started by start that are still playing, which wait is woken up by when it reaches 0
+	unsigned int runningThreads;
+	std::mutex mutex;
+	std::condition_variable stopped;
+
+	/*
+	Plays games on the current thread until the game limit or the deadline is reached or stop becomes true
+	@param thread The index of this thread, which picks its telemetry counters
+	@param seed1 The seed of this thread's first AI
+	@param seed2 The seed of this thread's second AI
+	@param maxGames The number of games to play across every thread (0 for no limit)
+	@param stop Set to true by another thread to end training early
+	@param deadline The time at which to stop playing
+	@param results Set to the totals of the games played by this thread
+	*/
+	void runWorker(const unsigned int& thread, const std::uint64_t& seed1, const std::uint64_t& seed2, const std::uint64_t& maxGames, const std::atomic<bool>& stop,
+		const std::chrono::steady_clock::time_point& deadline, Results& results);
+
+	/*
+	Plays batchSize games at once on the current thread until the game limit or the deadline is reached or stop becomes true
+	@param worker1 The AI that moves first in every game
+	@param worker2 The AI that moves second in every game
+	@param stats The counters of this thread, or nullptr if nothing is counted
+	@param maxGames The number of games to play across every thread (0 for no limit)
+	@param stop Set to true by another thread to end training early
+	@param deadline The time at which to stop starting new games
+	@param results Set to the totals of the games played by this thread
+	*/
+	void runBatches(AI<BoardT>& worker1, AI<BoardT>& worker2, Telemetry::ThreadStats* stats, const std::uint64_t& maxGames, const std::atomic<bool>& stop,
+		const std::chrono::steady_clock::time_point& deadline, Results& results);
+
+	/*
+	Teaches both AI objects the results of the given finished games, and frees the games to be played again
+	@param worker1 The AI that moved first in every game
+	@param worker2 The AI that moved second in every game
+	@param stats The counters of this thread, or nullptr if nothing is counted
+	@param games Every game of the batch
+	@param finishedGames The indices of the games to learn from, which is emptied
+	@param freeGames The indices of the games that can be played again, which the finished games are added to
+	@param results The totals the finished games are added to
+	*/
+	void learnFromBatch(AI<BoardT>& worker1, AI<BoardT>& worker2, Telemetry::ThreadStats* stats, std::vector<BatchGame>& games,
+		std::vector<std::size_t>& finishedGames, std::vector<std::size_t>& freeGames, Results& results);
+
+	/*
+	Finds the time at which training that starts now must stop
+	@param maxSeconds The number of seconds to play for (0 for no limit)
+	@return std::chrono::steady_clock::time_point The time to stop at
+	*/
+	static std::chrono::steady_clock::time_point deadlineAfter(const double& maxSeconds);
+};
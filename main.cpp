@@ -1,168 +1,381 @@
 #include <iostream>
 #include <string>
-#include <conio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <memory>
+#include <thread>
 #include "Board.h"
 #include "AI.h"
 #include "Random.h"
 #include "FileManager.h"
+#include "Trainer.h"
+#include "Console.h"
+#include "ProgramOptions.h"
+#include "Benchmark.h"
+#include "Checkpointer.h"
+#include "Solver.h"
+#include "Tablebase.h"
+#include "MonteCarloSearch.h"
+#include "Telemetry.h"
 #include <bitset>
 
-int main(int argc, char* argv) {
-	//Create a board
-	Board board;
-
-	//Initialize the random generation
-	Random::init();
+//Set by SIGINT and SIGTERM so training can stop and save instead of losing everything learned since the last save
+static std::atomic<bool> stopRequested(false);
 
-	std::cout << "Reading data, please wait...\n";
+/*
+Asks training to stop, which is all that can safely be done inside a signal handler
+*/
+extern "C" void requestStop(int) {
+	stopRequested = true;
+}
 
-	//Create objects for both AI save files
-	FileManager bot1Save("AI_Data/AI_1_data.txt");
-	FileManager bot2Save("AI_Data/AI_2_data.txt");
+/*
+Makes SIGINT and SIGTERM ask training to stop, or makes them end the program again as they normally would
+Only training catches them, so they still end the program from the menu, while playing and in every other mode
+@param catchSignals true while training or false once it has returned
+*/
+void catchStopSignals(const bool& catchSignals) {
+	std::signal(SIGINT, catchSignals ? requestStop : SIG_DFL);
+	std::signal(SIGTERM, catchSignals ? requestStop : SIG_DFL);
+}
 
-	//Create the two AI objects
-	AI AI1(Board::YELLOW_PIECE);
-	AI AI2(Board::RED_PIECE);
+/*
+Reads the data of the given AI and reports how quickly it was read
+@param save The save file of the AI
+@param ai The AI to read data for
+@return bool true if the data was read or there is none yet or false if the file exists but could not be read
+*/
+template <class BoardT>
+bool readData(FileManager<BoardT>& save, AI<BoardT>& ai) {
+	if (!save.readAIData(ai)) {
+		//Saving would replace the file with whatever was learned from an empty table
+		std::cout << "ERROR: Refusing to overwrite " << save.getFilename() << ", move or repair it first\n";
+		return false;
+	}
 
-	//Read all of the data for both AI objects
-	bot1Save.readAIData(AI1);
-	bot2Save.readAIData(AI2);
-	
-	//Initialize a variable to keep track of the number of moves each game takes
-	std::uint8_t numMoves = 0;
+	//The file may hold more boards than the memory limit allows
+	ai.trimToMemoryLimit();
 
-	bool running = true;
-	
-	//Code for checking efficiency
-	/*std::vector<std::chrono::milliseconds> times;
+	const double megabytes = static_cast<double>(save.getLastBytesRead()) / (1024 * 1024);
+	if (save.getLastReadSeconds() > 0) {
+		std::cout << "Read " << ai.getSharedData()->size() << " boards (" << megabytes << " MB) in " << save.getLastReadSeconds() << " seconds ("
+			<< megabytes / save.getLastReadSeconds() << " MB/s)\n";
+	}
 
-	std::chrono::milliseconds start, end;
+	return true;
+}
 
-	for (unsigned int it = 0; it < 100; it++) {
-		start = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
-		for (unsigned int x = 0; x < 100; x++) {
-			while (!board.isFull()) {
-				moves++;
+/*
+Reports how much of its memory limit the learned data of the given AI is using
+@param name The name of the AI
+@param ai The AI
+*/
+template <class BoardT>
+void printMemoryUsage(const std::string& name, const AI<BoardT>& ai) {
+	const auto& data = ai.getSharedData();
+
+	std::cout << name << " holds " << data->size() << " boards in " << static_cast<double>(data->memoryUsage()) / (1024 * 1024) << " MB of its "
+		<< static_cast<double>(data->getMemoryLimit()) / (1024 * 1024) << " MB limit, " << data->numEvictions() << " forgotten" << std::endl;
+}
 
-				if (board.checkForWin(AI1.makeMove(board))) {
-					AI1.learnFromGame(moves, true);
-					AI2.learnFromGame(moves, false);
+/*
+Makes the trainer count what its threads do and starts reporting it every few seconds, unless the reports are turned off
+@param trainer Trains the AI objects
+@param telemetry Counts what the training threads do
+@param AI1 The first AI, whose data must already be read
+@param AI2 The second AI, whose data must already be read
+@param options The settings given on the command line
+*/
+template <class BoardT>
+void startTelemetry(Trainer<BoardT>& trainer, const std::shared_ptr<Telemetry>& telemetry, const AI<BoardT>& AI1, const AI<BoardT>& AI2, const ProgramOptions& options) {
+	if (!Telemetry::ENABLED || options.statsSeconds <= 0) {
+		return;
+	}
 
-					moves = 0;
+	if (!telemetry->startReporting(options.statsSeconds, std::cout, options.statsPath, AI1.getSharedData()->size() + AI2.getSharedData()->size())) {
+		std::cout << "ERROR: Could not open file " << options.statsPath << "\n";
+		return;
+	}
 
-					board.clearBoard();
+	trainer.useTelemetry(telemetry);
+}
 
-					break;
-				}
+/*
+Trains both AI objects without any prompts until a limit is reached or a stop is requested, saving every checkpoint interval
+Checkpoints are written on a background thread, and the data is saved in full once training ends
+@param trainer Trains the AI objects
+@param telemetry Reports how training is going, which is stopped once training ends
+@param AI1 The first AI
+@param AI2 The second AI
+@param bot1Save The save file of the first AI
+@param bot2Save The save file of the second AI
+@param options The settings given on the command line
+*/
+template <class BoardT>
+void trainHeadless(Trainer<BoardT>& trainer, Telemetry& telemetry, AI<BoardT>& AI1, AI<BoardT>& AI2, FileManager<BoardT>& bot1Save, FileManager<BoardT>& bot2Save, const ProgramOptions& options) {
+	std::cout << "Training on " << trainer.getNumThreads() << " thread(s)";
+	if (options.maxGames != 0) {
+		std::cout << " for " << options.maxGames << " games";
+	}
+	if (options.maxSeconds > 0) {
+		std::cout << " for up to " << options.maxSeconds << " seconds";
+	}
+	std::cout << std::endl;
 
-				if (board.checkForWin(AI2.makeMove(board))) {
-					AI1.learnFromGame(moves, false);
-					AI2.learnFromGame(moves, true);
+	//Writes the checkpoints while training carries on
+	Checkpointer<BoardT> checkpointer;
+	checkpointer.add(AI1, bot1Save);
+	checkpointer.add(AI2, bot2Save);
 
-					moves = 0;
+	//The training threads keep playing through every checkpoint, which the writer saves from the tables while they change
+	trainer.start(options.maxGames, stopRequested, options.maxSeconds);
 
-					board.clearBoard();
+	std::uint64_t lastGames = 0;
+	auto lastCheckpoint = std::chrono::steady_clock::now();
 
-					break;
-				}
-			}
+	while (!trainer.wait(options.checkpointSeconds)) {
+		const auto now = std::chrono::steady_clock::now();
+		const std::uint64_t games = trainer.getGamesPlayed();
+		const double seconds = std::chrono::duration<double>(now - lastCheckpoint).count();
 
-			if (board.isFull()) {
-				AI1.endCurrentGame();
-				AI2.endCurrentGame();
+		std::cout << "Played " << games << " games (" << static_cast<std::uint64_t>(seconds > 0 ? (games - lastGames) / seconds : 0) << " per second)" << std::endl;
+		lastGames = games;
+		lastCheckpoint = now;
 
-				moves = 0;
+		if (options.memoryLimit > 0) {
+			printMemoryUsage("AI 1", AI1);
+			printMemoryUsage("AI 2", AI2);
+		}
 
-				board.clearBoard();
+		if (checkpointer.checkpoint(options.journal)) {
+			const auto stats = checkpointer.getStats();
+			std::cout << "Checkpoint " << stats.checkpoints << " is being written";
+			if (stats.checkpoints > 1) {
+				std::cout << " (the last one took " << stats.lastWriteSeconds * 1000 << " ms to write " << stats.lastBytesWritten << " bytes and kept shards locked for "
+					<< stats.lastStallSeconds * 1000 << " ms)";
 			}
+			std::cout << std::endl;
+		}
+		else {
+			std::cout << "The last checkpoint is still being written, so this one will be saved with the next" << std::endl;
 		}
-		end = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+	}
+
+	//The games have stopped, so the last report is not held back by the checkpoint still being written
+	telemetry.stopReporting();
+
+	//The writer must finish with the tables while they are still concurrent
+	checkpointer.wait();
 
-		times.emplace_back((end - start));
+	const auto totals = trainer.finish();
+
+	std::cout << "Played " << totals.gamesPlayed << " games in " << totals.seconds << " seconds ("
+		<< static_cast<std::uint64_t>(totals.gamesPerSecond()) << " per second), AI 1 won " << totals.ai1Wins
+		<< ", AI 2 won " << totals.ai2Wins << ", " << totals.draws << " draws" << std::endl;
+
+	if (options.memoryLimit > 0) {
+		printMemoryUsage("AI 1", AI1);
+		printMemoryUsage("AI 2", AI2);
 	}
 
-	std::int64_t totalTime = 0;
+	std::cout << "Saving..." << std::endl;
+	bot1Save.writeAIData(AI1);
+	bot2Save.writeAIData(AI2);
 
-	for (auto& time : times) {
-		totalTime += time.count();
+	const auto stats = checkpointer.getStats();
+	if (stats.checkpoints > 0) {
+		std::cout << stats.checkpoints << " checkpoint(s) wrote " << stats.totalBytesWritten << " bytes in " << stats.totalWriteSeconds << " seconds in the background and kept shards locked for "
+			<< stats.totalStallSeconds * 1000 << " ms in total (at most " << stats.longestStallSeconds * 1000 << " ms at once), " << stats.skipped << " skipped" << std::endl;
 	}
 
-	std::cout << "Times averaged out to " << totalTime / times.size() << " milliseconds";*/
+	std::cout << (stopRequested ? "Stopped early, all data has been saved" : "Training finished") << std::endl;
+}
 
-	//Start UI
-	while (running) {
-		std::cout << "Welcome to the Connect 4 AI Program!\nWould you like to train the AI further (t) or play against the AI (p)?: ";
-		std::string selection = std::string();
+/*
+Runs the program on the given type of board
+@param dataSuffix Added to the names of the AI data files so each board size keeps its own data
+@param options The settings given on the command line
+*/
+template <class BoardT>
+void runProgram(const std::string& dataSuffix, ProgramOptions& options) {
+	if (options.benchmark) {
+		//Benchmarks use their own AI objects and data, so the saved data is never touched
+		Benchmark<BoardT> benchmark(options.seeds.next(), options.numThreads, "benchmark_data" + dataSuffix + ".tmp");
+		benchmark.run(options.boardSize, std::cout);
+		return;
+	}
 
-		while (selection == "") {
-			std::getline(std::cin, selection);
+	//The tablebase holds the perfect move for every position, which the solver plays from whenever the file exists
+	const std::string tablebaseFilename = "AI_Data/tablebase" + dataSuffix + ".bin";
+
+	if (options.buildTablebase) {
+		std::cout << "Solving every position on " << options.numThreads << " thread(s), please wait...\n";
+
+		Tablebase<BoardT> tablebase;
+		const auto start = std::chrono::steady_clock::now();
+
+		if (!tablebase.generate(options.numThreads)) {
+			std::cout << "The " << options.boardSize << " board has too many positions for a tablebase\n";
+			return;
 		}
 
-		switch (tolower(selection.at(0))) {
-		case 't':
-			std::cout << "\nThe AI is now training against itself... (press any key to stop): ";
-			while (true) {
-				if (_kbhit()) {
-					_getche();
-					running = false;
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Solved " << tablebase.getNumPositions() << " positions in " << seconds << " seconds\n";
 
-					std::cout << "\nSaving... please wait...";
+		if (!tablebase.write(tablebaseFilename)) {
+			std::cout << "ERROR: Could not write file " << tablebaseFilename << "\n";
+		}
 
-					bot1Save.writeAIData(AI1);
-					bot2Save.writeAIData(AI2);
+		return;
+	}
 
-					break;
-				}
+	//Create a board
+	BoardT board;
 
-				while (!board.isFull()) {
-					numMoves++;
+	//Create objects for both AI save files
+	FileManager<BoardT> bot1Save(options.data1Path.empty() ? "AI_Data/AI_1_data" + dataSuffix + ".txt" : options.data1Path);
+	FileManager<BoardT> bot2Save(options.data2Path.empty() ? "AI_Data/AI_2_data" + dataSuffix + ".txt" : options.data2Path);
 
-					if (board.checkForWin(AI1.makeMove(board))) {
-						AI1.learnFromGame(numMoves, true);
-						AI2.learnFromGame(numMoves, false);
+	//Create the two AI objects
+	AI<BoardT> AI1(BoardT::YELLOW_PIECE, options.seeds.next());
+	AI<BoardT> AI2(BoardT::RED_PIECE, options.seeds.next());
+	AI1.useTactics(options.tactics);
+	AI2.useTactics(options.tactics);
+	AI1.setMemoryLimit(options.memoryLimit);
+	AI2.setMemoryLimit(options.memoryLimit);
+
+	//Trains both AI objects against each other
+	Trainer<BoardT> trainer(AI1, AI2, options.numThreads, options.seeds.next());
+	trainer.setBatchSize(options.batchSize);
+
+	//Counts the games, new boards and move times of every training thread
+	std::shared_ptr<Telemetry> telemetry = std::make_shared<Telemetry>(trainer.getNumThreads());
+
+	if (options.compact) {
+		std::cout << "Reading data, please wait...\n";
+		if (!readData(bot1Save, AI1) || !readData(bot2Save, AI2)) {
+			return;
+		}
 
-						numMoves = 0;
+		//Writing the whole data file folds the journal into it
+		std::cout << "\nCompacting...\n";
+		bot1Save.writeAIData(AI1);
+		bot2Save.writeAIData(AI2);
+		return;
+	}
 
-						board.clearBoard();
+	if (options.headless) {
+		std::cout << "Reading data, please wait...\n";
 
-						break;
-					}
+		//Read all of the data for both AI objects
+		if (!readData(bot1Save, AI1) || !readData(bot2Save, AI2)) {
+			return;
+		}
 
-					if (board.isFull()) {
-						AI1.endCurrentGame();
-						AI2.endCurrentGame();
+		//Checkpoints written to the journal need to know which boards have changed
+		AI1.getSharedData()->setTrackChanges(options.journal);
+		AI2.getSharedData()->setTrackChanges(options.journal);
 
-						numMoves = 0;
+		startTelemetry(trainer, telemetry, AI1, AI2, options);
+		catchStopSignals(true);
+		trainHeadless(trainer, *telemetry, AI1, AI2, bot1Save, bot2Save, options);
+		catchStopSignals(false);
+		return;
+	}
 
-						board.clearBoard();
+	bool running = true;
 
-						break;
-					}
+	//Start UI
+	while (running) {
+		std::cout << "Welcome to the Connect 4 AI Program!\nWould you like to train the AI further (t) or play against the AI (p)?: ";
+		std::string selection = std::string();
 
-					if (board.checkForWin(AI2.makeMove(board))) {
-						AI1.learnFromGame(numMoves, false);
-						AI2.learnFromGame(numMoves, true);
+		while (selection == "") {
+			std::getline(std::cin, selection);
+		}
 
-						numMoves = 0;
+		switch (tolower(selection.at(0))) {
+		case 't':
+		{
+			std::cout << "Reading data, please wait...\n";
 
-						board.clearBoard();
+			//Read all of the data for both AI objects
+			if (!readData(bot1Save, AI1) || !readData(bot2Save, AI2)) {
+				return;
+			}
 
-						break;
-					}
-				}
+			std::cout << "\nThe AI is now training against itself on " << trainer.getNumThreads() << " thread(s)... (press any key to stop): " << std::endl;
+			startTelemetry(trainer, telemetry, AI1, AI2, options);
 
-				if (board.isFull()) {
-					AI1.endCurrentGame();
-					AI2.endCurrentGame();
+			//Train on another thread so this one can wait for a key press
+			std::atomic<bool> stopTraining(false);
+			typename Trainer<BoardT>::Results results;
+			catchStopSignals(true);
+			std::thread trainingThread([&]() { results = trainer.train(0, stopTraining); });
 
-					numMoves = 0;
+			while (!Console::keyPressed() && !stopRequested) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			}
 
-					board.clearBoard();
-				}
+			if (!stopRequested) {
+				Console::readKey();
 			}
+
+			stopTraining = true;
+			trainingThread.join();
+			telemetry->stopReporting();
+			running = false;
+
+			std::cout << "\nPlayed " << results.gamesPlayed << " games (" << static_cast<std::uint64_t>(results.gamesPerSecond()) << " per second)\n";
+
+			if (options.memoryLimit > 0) {
+				printMemoryUsage("AI 1", AI1);
+				printMemoryUsage("AI 2", AI2);
+			}
+
+			std::cout << "Saving... please wait...";
+
+			bot1Save.writeAIData(AI1);
+			bot2Save.writeAIData(AI2);
+			catchStopSignals(false);
+		}
 			break;
 		case 'p':
 		{
+			selection = std::string();
+
+			while (selection == "" || (tolower(selection.at(0)) != 'a' && tolower(selection.at(0)) != 's' && tolower(selection.at(0)) != 'm')) {
+				std::cout << "Would you like to play against the learned AI (a), the solver (s) or Monte Carlo search (m)?: ";
+				std::getline(std::cin, selection);
+			}
+
+			//The solver plays perfectly on small boards and as well as it can in the time allowed on larger ones
+			//Monte Carlo search needs nothing loaded, so it plays on every board size straight away
+			const bool useSolver = tolower(selection.at(0)) == 's';
+			const bool useSearch = tolower(selection.at(0)) == 'm';
+			Solver<BoardT> solver1(BoardT::YELLOW_PIECE, options.solverSeconds);
+			Solver<BoardT> solver2(BoardT::RED_PIECE, options.solverSeconds);
+			const typename MonteCarloSearch<BoardT>::Parallelism parallelism = options.rootParallel ? MonteCarloSearch<BoardT>::Parallelism::ROOT : MonteCarloSearch<BoardT>::Parallelism::TREE;
+			MonteCarloSearch<BoardT> search1(BoardT::YELLOW_PIECE, options.seeds.next(), options.searchPlayouts, options.searchSeconds, options.numThreads, parallelism);
+			MonteCarloSearch<BoardT> search2(BoardT::RED_PIECE, options.seeds.next(), options.searchPlayouts, options.searchSeconds, options.numThreads, parallelism);
+
+			if (useSolver) {
+				std::shared_ptr<Tablebase<BoardT>> tablebase = std::make_shared<Tablebase<BoardT>>();
+
+				if (tablebase->read(tablebaseFilename)) {
+					solver1.useTablebase(tablebase);
+					solver2.useTablebase(tablebase);
+				}
+			}
+			else if (!useSearch) {
+				//Play from memory-mapped models, which only need to be read from the data the first time
+				std::cout << "Loading the AI, please wait...\n";
+				bot1Save.readFrozenModel(AI1);
+				bot2Save.readFrozenModel(AI2);
+			}
+
 			bool allFinished = false;
 
 			while (!allFinished) {
@@ -190,11 +403,12 @@ int main(int argc, char* argv) {
 							col = input - 1;
 
 							if (board.validMove(col)) {
-								board.addPiece(col, Board::YELLOW_PIECE);
+								board.addPiece(col, BoardT::YELLOW_PIECE);
 
 								if (board.checkForWin(col)) {
 									board.printBoard();
 									board.clearBoard();
+									AI2.endCurrentGame();
 
 									while (gameIsPlaying) {
 										std::cout << "\nYou won! Would you like to play again? (y/n): ";
@@ -228,9 +442,10 @@ int main(int argc, char* argv) {
 						}
 
 						//AI
-						if (board.checkForWin(AI2.makeMove(board))) {
+						if (board.checkForWin(useSolver ? solver2.makeMove(board) : (useSearch ? search2.makeMove(board) : AI2.makeMove(board)))) {
 							board.printBoard();
 							board.clearBoard();
+							AI2.endCurrentGame();
 
 							while (gameIsPlaying) {
 								std::cout << "\nYou lost... Would you like to play again? (y/n): ";
@@ -259,6 +474,7 @@ int main(int argc, char* argv) {
 						if (board.isFull()) {
 							board.printBoard();
 							board.clearBoard();
+							AI2.endCurrentGame();
 
 							while (gameIsPlaying) {
 								std::cout << "\nYou tied. Would you like to play again? (y/n): ";
@@ -289,9 +505,10 @@ int main(int argc, char* argv) {
 					board.clearBoard();
 					while (gameIsPlaying) {
 						//AI
-						if (board.checkForWin(AI1.makeMove(board))) {
+						if (board.checkForWin(useSolver ? solver1.makeMove(board) : (useSearch ? search1.makeMove(board) : AI1.makeMove(board)))) {
 							board.printBoard();
 							board.clearBoard();
+							AI1.endCurrentGame();
 
 							while (gameIsPlaying) {
 								std::cout << "\nYou lost... Would you like to play again? (y/n): ";
@@ -328,11 +545,12 @@ int main(int argc, char* argv) {
 							col = input - 1;
 
 							if (board.validMove(col)) {
-								board.addPiece(col, Board::RED_PIECE);
+								board.addPiece(col, BoardT::RED_PIECE);
 
 								if (board.checkForWin(col)) {
 									board.printBoard();
 									board.clearBoard();
+									AI1.endCurrentGame();
 
 									while (gameIsPlaying) {
 										std::cout << "\nYou won! Would you like to play again? (y/n): ";
@@ -368,6 +586,7 @@ int main(int argc, char* argv) {
 						if (board.isFull()) {
 							board.printBoard();
 							board.clearBoard();
+							AI1.endCurrentGame();
 
 							while (gameIsPlaying) {
 								std::cout << "\nYou tied. Would you like to play again? (y/n): ";
@@ -409,3 +628,27 @@ int main(int argc, char* argv) {
 
 	std::cout << "\n\nIt is now safe to exit";
 }
+
+int main(int argc, char* argv[]) {
+	ProgramOptions options;
+
+	if (!options.parse(argc, argv)) {
+		return 1;
+	}
+
+	if (options.boardSize == "4x5") {
+		runProgram<Board4x5>("", options);
+	}
+	else if (options.boardSize == "5x6") {
+		runProgram<Board5x6>("_5x6", options);
+	}
+	else if (options.boardSize == "6x7") {
+		runProgram<Board6x7>("_6x7", options);
+	}
+	else {
+		std::cout << "Unknown board size " << options.boardSize << " (expected 4x5, 5x6 or 6x7)\n";
+		return 1;
+	}
+
+	return 0;
+}